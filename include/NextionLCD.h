@@ -1,33 +1,53 @@
 #include <FlexCAN_T4.h>
+#include <nextionCommand.h>
 
 #define pgBtnPin A17
-bool pgBtnBool = false;
+#define PAGE_BTN_DEBOUNCE_MS 300            // a held button pages on once per this, the ISR fires for as long as it's HIGH
+volatile uint32_t pgBtnLastPress;           // millis() of the last press pageBtnPressed() took
+volatile int8_t pgBtnRequest = -1;          // page the button asked for, loop() changes to it, -1 for none
 
 FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
 
 enum BSPD {Standby, Trig, TRIP};            // BSPD statuses
 enum Screen {Config1, Config2, DragMode, Params, BSPD_Trig, BSPD_Trip, Shift, SlowDown};  //  Screen Mode
+#define SCREEN_COUNT 8
 
-long unsigned int timeHolder;               // used to measure the amount of elapsed time since isSilentTime's value has changed
 long unsigned int showTimeHolder;
-long unsigned int silenceTime = 50;         // time between the inversion of isSilentTime's value
-bool isSilentTime = false;                  // locks out normal CAN message processing, so the one-shot GearP CAN message can be listened for
+
+/**
+ * @brief Key-on to live data timing, getTime() of each milestone, printed once over USB serial by reportBootTiming()
+ *
+ */
+#define BOOT_NOT_YET 0xFFFFFFFF
+
+struct BootTiming
+{
+  uint32_t setupStart = BOOT_NOT_YET;       // setup() entered
+  uint32_t canStarted = BOOT_NOT_YET;       // FlexCAN recieving
+  uint32_t lcdReady = BOOT_NOT_YET;         // LCD baud negotiated and the opening screen queued
+  uint32_t firstRPM = BOOT_NOT_YET;         // first RPM frame decoded
+  uint32_t firstLiveValue = BOOT_NOT_YET;   // first value written to the LCD after that
+  uint8_t firstLiveParam;                   // its paramCode
+  bool reported;
+};
+
+BootTiming bootTiming;
 
 Screen currScreen;                          // holds the last screen changed before BSDP Trip, Trig, or Shift screen changes
 bool irregScreen;                           // a bool flag set when BSPD Trip, Trig, or Shift screen changes occur, used for resetting to last screen
 
-double currBatt;                            // battery voltage                      paramCode 0
+int currBatt;                               // battery voltage (hundredths)         paramCode 0
 //char currBSPDState;                       // status of the BSPD                   paramCode 1      0=Stdby; 1=Trig; 2=Trip
 int currECT;                                // current engine coolant temp          paramCode 2
 int currFrontBP;                            // front brake bias pressure            paramCode 3
 int currRearBP;                             // rear brake bias pressure             paramCode 4
 int currFuelPSR;                            // fuel pressure                        paramCode 5
 int currGearP;                              // gear position                        paramCode 6
-double currLamb;                            // engine lambda (AFR)                  paramCode 7
+int currLamb;                               // engine lambda (AFR, hundredths)      paramCode 7
 int currMAP;                                // manifold airpressure                 paramCode 8
 int currOilPSR;                             // oil pressure                         paramCode 9
 int currRPM;                                // RPM                                  paramCode 10
-double currThrtl;                           // throttle pedal %                     paramCode 11
+int currThrtl;                              // throttle pedal % (hundredths)        paramCode 11
 long unsigned int currTimerDel;             // master timer time delta              paramCode 12     
 char currTimerDelPic;                       // LCD imageID for master timer delta   paramCode 13     0=NegDelt; 1=PosDelt
 int maxWSpd;                                // maximum all-drive wheelspeed         paramCode 14
@@ -40,16 +60,315 @@ char WARN_OPRSR;                            // status of oil pressure warn
 
 /* Newly Added Params*/
 int currOilTemp;                            // engine oil temperature               paramCode 22
+BSPD currBSPD = Standby;                    // status of the BSPD, from the BSPD screens                 packed into paramCode 23
+
+#define PARAM_COUNT 24
+#define PARAM_PREFIX_MAX 17                 // longest prefix ("timer_Delta.txt=") + null
+#define PARAM_CMD_MAX (PARAM_PREFIX_MAX + 17) // longest paramCode command, the prefix + "\"-21474836.48\"" + terminator
+
+/**
+ * @brief Nextion component and attribute of every paramCode, kept in flash and handed to the nextionCommand
+ * formatters as the command prefix. paramCode 1 (BSPD state) has no component on the LCD
+ *
+ */
+const char paramPrefix[PARAM_COUNT][PARAM_PREFIX_MAX] PROGMEM = {
+    "Batt.txt=",                            // paramCode 0
+    "",                                     // paramCode 1
+    "ETC.val=",                             // paramCode 2
+    "FrontBP.val=",                         // paramCode 3
+    "RearBP.val=",                          // paramCode 4
+    "fuelPRSR.val=",                        // paramCode 5
+    "gearPos.val=",                         // paramCode 6
+    "Lam.txt=",                             // paramCode 7
+    "Map.val=",                             // paramCode 8
+    "oilPRSR.val=",                         // paramCode 9
+    "RPM.val=",                             // paramCode 10
+    "Thrt.txt=",                            // paramCode 11
+    "timer_Delta.txt=",                     // paramCode 12
+    "pic_Delta.pic=",                       // paramCode 13
+    "MaxWS.val=",                           // paramCode 14
+    "timer_R1.txt=",                        // paramCode 15
+    "timer_R2.txt=",                        // paramCode 16
+    "timer_R3.txt=",                        // paramCode 17
+    "WARN_ECTO.pic=",                       // paramCode 18
+    "WARN_FPRSR.pic=",                      // paramCode 19
+    "WARN_OTEMP.pic=",                      // paramCode 20
+    "WARN_OPRSR.pic=",                      // paramCode 21
+    "oilTEMP.val=",                         // paramCode 22
+    "dashFlags=",                           // paramCode 23, LCD_PACKED_FLAGS only
+};
+
+/**
+ * @brief Packed display flags (build with -D LCD_PACKED_FLAGS)
+ *
+ * Every on/off bit of display state goes out as one numeric write to the HMI's dashFlags global ("dashFlags=37",
+ * 15 bytes) instead of one picture command per warning (20+ bytes each). The HMI unpacks it with a timer on each
+ * page, so the HMI has to be built with the snippet below to use this mode.
+ *
+ * Program.s:
+ *
+ *     int dashFlags=0
+ *
+ * On each page, a number variable lastFlags (local, val=-1 so the page unpacks on load) and a timer
+ * (tim=50, en=1) with this Timer Event, leaving out the lines for components the page doesn't have. Nextion's
+ * if() can only compare two operands, so every bit is masked into sys0 first, and vis wants exactly 0 or 1:
+ *
+ *     if(dashFlags!=lastFlags.val)
+ *     {
+ *       lastFlags.val=dashFlags
+ *       WARN_ECTO.pic=4
+ *       sys0=dashFlags&1
+ *       if(sys0!=0)
+ *       {
+ *         WARN_ECTO.pic=1
+ *       }
+ *       WARN_FPRSR.pic=4
+ *       sys0=dashFlags&2
+ *       if(sys0!=0)
+ *       {
+ *         WARN_FPRSR.pic=2
+ *       }
+ *       WARN_OTEMP.pic=4
+ *       sys0=dashFlags&4
+ *       if(sys0!=0)
+ *       {
+ *         WARN_OTEMP.pic=3
+ *       }
+ *       WARN_OPRSR.pic=4
+ *       sys0=dashFlags&8
+ *       if(sys0!=0)
+ *       {
+ *         WARN_OPRSR.pic=10
+ *       }
+ *       sys0=dashFlags>>4
+ *       sys0=sys0&1
+ *       vis shiftLight,sys0
+ *       pic_Delta.pic=6
+ *       sys0=dashFlags&32
+ *       if(sys0!=0)
+ *       {
+ *         pic_Delta.pic=7
+ *       }
+ *       sys1=dashFlags>>6
+ *       sys1=sys1&3
+ *       bspdState.val=sys1
+ *     }
+ */
+#define PARAM_DASH_FLAGS 23
+#define DASH_FLAG_WARN_ECTO (1 << 0)
+#define DASH_FLAG_WARN_FPRSR (1 << 1)
+#define DASH_FLAG_WARN_OTEMP (1 << 2)
+#define DASH_FLAG_WARN_OPRSR (1 << 3)
+#define DASH_FLAG_SHIFT (1 << 4)            // shift light on, RPM at or projected past the gear's shift point
+#define DASH_FLAG_TIMER_POS (1 << 5)        // timer delta is positive (pic 7)
+#define DASH_FLAG_BSPD_SHIFT 6              // 2 bits, BSPD enum
+
+/**
+ * @brief paramCodes each screen has a component for, chngParamVal() only sends a paramCode if its bit is set
+ * for currScreen
+ *
+ */
+#define PARAM_BIT(paramCode) (1UL << (paramCode))
+
+#ifdef LCD_PACKED_FLAGS
+#define PARAM_FLAG_BITS PARAM_BIT(PARAM_DASH_FLAGS)
+#define PARAM_PIC_BIT(paramCode) 0          // the pictures are set by the HMI from dashFlags
+#else
+#define PARAM_FLAG_BITS (PARAM_BIT(18) | PARAM_BIT(19) | PARAM_BIT(20) | PARAM_BIT(21))
+#define PARAM_PIC_BIT(paramCode) PARAM_BIT(paramCode)
+#endif
+
+/**
+ * @brief paramCodes that feed dashFlags, a change to any of them re-packs it
+ *
+ */
+#define DASH_FLAG_SOURCES (PARAM_BIT(6) | PARAM_BIT(10) | PARAM_BIT(13) |                                \
+                           PARAM_BIT(18) | PARAM_BIT(19) | PARAM_BIT(20) | PARAM_BIT(21))
+
+#define PARAMS_EVERY_SCREEN (PARAM_BIT(0) | PARAM_BIT(7) | PARAM_BIT(11) | PARAM_BIT(12) |               \
+                             PARAM_BIT(15) | PARAM_BIT(16) | PARAM_BIT(17) | PARAM_FLAG_BITS)
+#ifdef LCD_TRACE
+#define PARAMS_TRACED (PARAM_BIT(7) | PARAM_BIT(11)) // lambda, throttle, drawn by the waveform on DragMode, see lcdTrace.h
+#else
+#define PARAMS_TRACED 0
+#endif
+
+const uint32_t screenParams[SCREEN_COUNT] = {
+    PARAMS_EVERY_SCREEN | PARAM_BIT(3) | PARAM_BIT(4) | PARAM_BIT(6) | PARAM_BIT(10),     // Config1: brake pressures, gear, RPM
+    PARAMS_EVERY_SCREEN | PARAM_BIT(6) | PARAM_PIC_BIT(13),                               // Config2: gear, timer delta pic
+    (PARAMS_EVERY_SCREEN & ~PARAMS_TRACED) | PARAM_BIT(6) | PARAM_BIT(14),                // DragMode: gear, max wheelspeed
+    PARAMS_EVERY_SCREEN | PARAM_BIT(2) | PARAM_BIT(5) | PARAM_BIT(8) | PARAM_BIT(9) |     // Params: temps, pressures, MAP,
+        PARAM_BIT(14) | PARAM_BIT(22),                                                    //   max wheelspeed
+    PARAMS_EVERY_SCREEN,                                                                  // BSPD_Trig
+    PARAMS_EVERY_SCREEN,                                                                  // BSPD_Trip
+    PARAMS_EVERY_SCREEN,                                                                  // Shift
+    PARAMS_EVERY_SCREEN,                                                                  // SlowDown
+};
+
+long unsigned int lcdBaud = NEXTION_DEFAULT_BAUD; // Serial1 baud rate to the LCD, set by nextionNegotiateBaud()
+#define LCD_BAUD_EEPROM_ADDR 0              // EEPROM address of the last negotiated lcdBaud (uint32_t)
+
+/**
+ * @brief Shadow copy of what was last written to each paramCode's component, see writeParam()
+ *
+ */
+struct ParamCache
+{
+  bool valid;                               // false until the first write, and again after every page change
+  int32_t lastVal;                          // value of the last command sent
+  int8_t lastDir;                           // direction of the last sent change, -1, 0 or 1
+  uint8_t renderedLen;                      // length of rendered, 0 if the command didn't fit
+  char rendered[PARAM_CMD_MAX];             // the last command sent, byte for byte
+};
+
+/**
+ * @brief Per-component update thresholds, in the paramCode's own units (hundredths for fixed-point params)
+ *
+ * A value has to move at least deadband away from the last value sent to be written. If it reverses direction
+ * it has to move deadband (at least 1) + hysteresis, so a reading flickering between two values isn't re-sent.
+ * Dropping to 0 is always written, so a stopped engine or a closed throttle never leaves the last reading up.
+ */
+struct ParamDeadband
+{
+  uint16_t deadband;
+  uint16_t hysteresis;
+};
+
+const ParamDeadband paramDeadband[PARAM_COUNT] = {
+    {5, 5},                                 // paramCode 0  battery, 0.05 V
+    {0, 0},                                 // paramCode 1
+    {0, 1},                                 // paramCode 2  coolant temp
+    {0, 1},                                 // paramCode 3  front brake pressure
+    {0, 1},                                 // paramCode 4  rear brake pressure
+    {0, 1},                                 // paramCode 5  fuel pressure
+    {0, 0},                                 // paramCode 6  gear position
+    {1, 1},                                 // paramCode 7  lambda, 0.01
+    {0, 1},                                 // paramCode 8  MAP
+    {0, 1},                                 // paramCode 9  oil pressure
+    {50, 50},                               // paramCode 10 RPM
+    {50, 50},                               // paramCode 11 throttle, 0.5 %
+    {0, 0},                                 // paramCode 12 timer delta, only changes once a second when rendered
+    {0, 0},                                 // paramCode 13 timer delta pic
+    {0, 0},                                 // paramCode 14 max wheelspeed
+    {0, 0},                                 // paramCode 15 timer 1
+    {0, 0},                                 // paramCode 16 timer 2
+    {0, 0},                                 // paramCode 17 timer 3
+    {0, 0},                                 // paramCode 18 WARN_ECTO
+    {0, 0},                                 // paramCode 19 WARN_FPRSR
+    {0, 0},                                 // paramCode 20 WARN_OTEMP
+    {0, 0},                                 // paramCode 21 WARN_OPRSR
+    {0, 1},                                 // paramCode 22 oil temp
+    {0, 0},                                 // paramCode 23 dashFlags
+};
+
+ParamCache paramCache[PARAM_COUNT];
+
+/**
+ * @brief LCD frame composer, chngParamVal() only queues values and composeLCDFrame() writes them out at a fixed
+ * rate, so LCD traffic follows what the driver can see instead of how busy the CAN bus is
+ *
+ */
+#ifndef LCD_FRAME_HZ
+#define LCD_FRAME_HZ 20                     // LCD refreshes per second
+#endif
+
+/**
+ * @brief Screens whose LCD frames are wrapped in ref_stop/ref_star, each wrapped frame costs LCD_BATCH_OVERHEAD
+ * bytes of its budget
+ *
+ * Batching only kicks in once lcdBaud is at least LCD_BATCH_MIN_BAUD. At 9600 a frame is 48 bytes and the
+ * wrapper would take almost half of it, at 38400 it's about a tenth.
+ */
+#ifndef LCD_BATCH_SCREENS
+#define LCD_BATCH_SCREENS ((1 << Config1) | (1 << Config2) | (1 << DragMode) | (1 << Params))
+#endif
+#ifndef LCD_BATCH_MIN_BAUD
+#define LCD_BATCH_MIN_BAUD 38400
+#endif
+#define LCD_BATCH_OVERHEAD 22               // "ref_stop" + "ref_star", terminators included
+
+enum ParamFormat
+{
+  PARAM_INT,                                // RPM.val=9500
+  PARAM_FIXED_TXT,                          // Batt.txt="12.34", value multiplied by 10^decimals
+  PARAM_TIME_TXT                            // timer_R1.txt="1:23", value in msec
+};
+
+struct ParamPending
+{
+  int32_t val;                              // latest value from chngParamVal(), as displayed
+  uint8_t format;                           // ParamFormat
+  uint8_t decimals;                         // PARAM_FIXED_TXT decimal places
+};
+
+ParamPending paramPending[PARAM_COUNT];
+uint32_t paramPendingMask;                  // paramCodes queued for the next LCD frame
+uint32_t paramKnownMask;                    // paramCodes chngParamVal() has been given a value for, see replayScreen()
+
+static_assert(PARAM_COUNT <= 32, "paramPendingMask only has 32 bits");
+
+/**
+ * @brief Order paramCodes are written within a frame: gear, RPM and warnings first, temps and timers last
+ *
+ */
+const uint8_t lcdFramePriority[PARAM_COUNT] = {
+    6, 10,                                  // gear position, RPM
+    18, 19, 20, 21, 23,                     // warnings, dashFlags
+    9, 5, 3, 4, 8,                          // pressures, MAP
+    11, 7, 0, 14, 13,                       // throttle, lambda, battery, max wheelspeed, timer delta pic
+    2, 22,                                  // temps
+    12, 15, 16, 17,                         // timers
+    1,
+};
+
+struct LCDLinkStats
+{
+  uint32_t bytesSent;                       // bytes written to Serial1
+  uint32_t bytesSaved;                      // bytes of commands suppressed by the value cache
+  uint32_t cmdsSent;
+  uint32_t cmdsSaved;
+  uint32_t carriedOver;                     // queued commands pushed to the next frame by the frame budget
+  uint32_t framesBatched;                   // frames wrapped in ref_stop/ref_star
+};
+
+LCDLinkStats lcdStats;
+
+/**
+ * @brief Adaptive LCD send rate, see adaptLCDRate()
+ *
+ * The frame budget is scaled by lcdRatePercent. It's halved whenever the LCD reports a serial buffer overflow
+ * or answers slower than LCD_ACK_SLOW_MS on average, and creeps back up by LCD_RATE_STEP_UP after every
+ * LCD_RATE_CLEAN_FRAMES frames without trouble.
+ */
+#define LCD_RATE_MIN_PERCENT 10
+#define LCD_RATE_STEP_UP 5
+#define LCD_RATE_CLEAN_FRAMES 10
+#define LCD_ACK_SLOW_MS (2000 / LCD_FRAME_HZ) // 2 frames
+
+uint8_t lcdRatePercent = 100;               // share of the link budget the frame composer may use
 
 void canSniff(const CAN_message_t &msg);
 void CANmsgRecieve(const CAN_message_t &msg);
 void chngScrn(int scrnCode);               
-void chngParamVal(int paramCode, double val);
 void chngParamVal(int paramCode, int val);
-void endCommand();
 void pageBtnPressed();
+Screen nextNormScrn(Screen from);
+void handlePageBtn();
 void returnToLastNormScrn();
 void chngScrnSlowDown();
 
-String convMSec_to_TForm(long unsigned int val);
 long unsigned int getTime();
+void invalidateParamCache();
+bool paramSuppressed(int paramCode, int32_t val, const char *cmd, uint8_t len);
+bool writeParam(int paramCode, int32_t val, const char *cmd, uint8_t len, uint16_t &budget);
+void queueParam(int paramCode, int32_t val, ParamFormat format, uint8_t decimals);
+void queueParamInt(int paramCode, int32_t val);
+void queueParamFixedTxt(int paramCode, int32_t val, uint8_t decimals);
+void queueParamTimeTxt(int paramCode, uint32_t msec);
+uint8_t formatParam(char *cmd, uint8_t paramCode);
+void composeLCDFrame();
+void replayScreen(Screen page);
+uint8_t packDashFlags();
+void adaptLCDRate();
+void printLCDStats();
+void reportBootTiming();
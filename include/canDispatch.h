@@ -0,0 +1,142 @@
+#include <FlexCAN_T4.h>
+
+/**
+ * @brief Table-driven dispatch of MoTeC M150 CAN frames to per-frame decoder functions
+ *
+ * The M150 transmits every dashboard channel inside the 0x640-0x64F window, so those IDs index a
+ * dense array directly (one subtraction + one bounds check). Any ID outside of that window lands in
+ * a small open-addressed hash table instead, so the ISR cost stays flat regardless of which ID arrives.
+ *
+ * Each ID owns a slot holding up to MAX_DECODERS_PER_ID decoders, and each decoder carries a bitmask
+ * of the screens it runs on, replacing the copy-pasted per-screen if/else chains.
+ *
+ * The FlexCAN ISR doesn't decode anything, it only copies the frame into its ID's slot, bumps the slot's
+ * sequence counter and flags the slot in canPendingMask. loop() then decodes each flagged slot once, so a
+ * burst of the same ID coalesces into a single decode and a slow LCD write can't back up into the FIFO.
+ *
+ * Pending slots are decoded in CANPriority order, and each slot can set a minimum interval between decodes.
+ * A slot that is rate limited stays pending, so its frames keep coalescing and the newest one is decoded once
+ * the interval is up, nothing is thrown away to give gear position a turn.
+ */
+
+#define CAN_ID_BASE 0x640           // first ID of the M150 dash broadcast window (RPM)
+#define CAN_ID_COUNT 16             // 0x640 - 0x64F
+#define CAN_OUTLIER_SLOTS 8         // hash table size for IDs outside of the window, must be a power of 2
+#define CAN_OUTLIER_EMPTY 0xFFFFFFFF
+#define MAX_DECODERS_PER_ID 3
+#define CAN_PENDING_BITS (CAN_ID_COUNT + CAN_OUTLIER_SLOTS)   // one canPendingMask bit per dense + outlier slot
+
+static_assert(CAN_PENDING_BITS <= 32, "canPendingMask only has 32 bits");
+
+/**
+ * @brief Latency-critical fast path, RPM (shift lights) and gear position get their own RX mailboxes with
+ * their own handlers instead of queueing behind temperature frames in the FIFO
+ *
+ * Mailboxes are matched before the FIFO (setMRP), so how deep the FIFO is never delays these two IDs.
+ * Set CAN_FAST_PATH to 0 to send everything through the FIFO again.
+ */
+#ifndef CAN_FAST_PATH
+#define CAN_FAST_PATH 1
+#endif
+#define CAN_FAST_PATH_MB_RPM MB8
+#define CAN_FAST_PATH_MB_GEAR MB9
+
+/**
+ * @brief FlexCAN acceptance filtering, programmed from the dispatch table by setupCANFilters()
+ *
+ * With RFFN_8 the RX FIFO and its 8 filter table entries take up MB0-MB7, leaving MB8-MB15 (setMaxMB(16)) for
+ * the fast path and as filtered RX mailboxes for any IDs that don't fit into the FIFO table.
+ */
+#define CAN_FIFO_FILTERS 8                          // filter table entries for RFFN_8
+#define CAN_FIRST_FILTER_MB (CAN_FAST_PATH ? 10 : 8) // first mailbox left after the FIFO's filter table and the fast path
+#define CAN_LAST_FILTER_MB 15                       // last mailbox, setMaxMB(16)
+
+/**
+ * @brief Builds a decoder screen mask from the Screen enum in NextionLCD.h
+ *
+ */
+#define SCREEN_MASK(scrn) (1 << (scrn))
+#define ALL_SCREENS 0xFF
+
+/**
+ * @brief Decode order within a processCANFrames() pass
+ *
+ */
+enum CANPriority
+{
+  PRIORITY_CRITICAL,                        // gear position, RPM: decoded immediately, every pass
+  PRIORITY_HIGH,                            // pressures and their warnings
+  PRIORITY_LOW,                             // slow moving channels: temps, battery, throttle, wheelspeed
+  PRIORITY_COUNT
+};
+
+typedef void (*CANDecoderFn)(const CAN_message_t &msg);
+
+struct CANDecoder
+{
+  CANDecoderFn decode;                      // extracts the channel(s) from the frame and updates the LCD
+  uint8_t screenMask;                       // screens the decoder runs on, see SCREEN_MASK()
+};
+
+struct CANSlotStats
+{
+  uint32_t processed;                       // frames decoded
+  uint32_t coalesced;                       // frames overwritten before loop() got to the slot, loop() running late
+  uint32_t dropped;                         // frames overwritten while the slot was held back by its minInterval
+};
+
+struct CANDispatchSlot
+{
+  CANDecoder decoders[MAX_DECODERS_PER_ID];
+  uint8_t decoderCount;
+  uint8_t pendingBit;                       // the slot's bit in canPendingMask
+  uint8_t priority;                         // CANPriority
+  uint16_t minInterval;                     // minimum time between decodes (ms), 0 decodes every frame
+  long unsigned int lastDecodeTime;         // getTime() of the last decode
+  bool fastPath;                            // recieved through a dedicated mailbox, kept out of the FIFO filters
+  CANSlotStats stats;
+
+  CAN_message_t latest;                     // last frame deposited by the ISR, only read with interrupts off
+  volatile uint32_t seq;                    // frames deposited by the ISR
+  uint32_t processedSeq;                    // seq of the last frame decoded by loop()
+  bool held;                                // a pass found the slot inside its minInterval, the frame is waiting
+  uint32_t heldSeq;                         // seq when it was first held, later frames count as dropped
+};
+
+struct CANOutlierSlot
+{
+  uint32_t id;                              // CAN_OUTLIER_EMPTY when unused
+  CANDispatchSlot slot;
+};
+
+CANDispatchSlot canDispatch[CAN_ID_COUNT];
+CANOutlierSlot canOutliers[CAN_OUTLIER_SLOTS];
+volatile uint32_t canPendingMask;           // slots holding a frame that loop() hasn't decoded yet
+uint32_t canPriorityMask[PRIORITY_COUNT];   // pendingBits of the slots in each CANPriority
+
+struct CANFilterStats
+{
+  volatile uint32_t recieved;               // frames that made it through the hardware filters into the ISR
+  volatile uint32_t rejected;               // of those, frames with no decoder (should stay at 0 with filtering on)
+  uint32_t rateSince;                       // millis() getCANInterruptRate() last measured from
+  uint32_t rateFrames;                      // recieved at that point
+};
+
+CANFilterStats canFilterStats;
+
+CANDispatchSlot *findCANSlot(uint32_t id, bool create);
+bool registerCANDecoder(uint32_t id, CANDecoderFn decode, uint8_t screenMask);
+bool setCANPriority(uint32_t id, CANPriority priority, uint16_t minInterval);
+void initCANDispatch();
+CANDispatchSlot *slotFromPendingBit(uint8_t bit);
+uint32_t idFromPendingBit(uint8_t bit);
+void rpmFastPathRecieve(const CAN_message_t &msg);
+void gearFastPathRecieve(const CAN_message_t &msg);
+void setupCANFastPath();
+uint8_t canFilterBlockEnd(const uint32_t *ids, uint8_t i, uint8_t idCount);
+uint8_t setupCANFilters();
+uint32_t getCANRejectedFrames();
+uint32_t getCANInterruptRate();
+bool dispatchCANFrame(const CANDispatchSlot &slot, const CAN_message_t &msg);
+void processCANFrames();
+void printCANStats();
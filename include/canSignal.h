@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Compile-time CAN signal descriptors
+ *
+ * A signal is described entirely by template parameters, so every CANSignal<> is its own type whose
+ * raw() and value() collapse to a handful of loads, shifts and one multiply-add at compile time.
+ * Nothing about the layout is looked up or interpreted while the ISR is running.
+ *
+ * Scaling follows the MoTeC C125 Dash Manager convention: value = raw * Multiplier / Divisor + Adder,
+ * which gives the value in the unit MoTeC transmits. Unit then converts that to what the LCD displays.
+ *
+ * The whole chain (C125 scaling, unit conversion and the display's decimal places) is folded at compile
+ * time into one Q24 fixed-point multiplier and one Q24 offset, so value() is a single 32x32->64 multiply-add
+ * and a rounding shift. No float or double math happens per frame.
+ */
+
+#define SIGNAL_Q_BITS 24            // fractional bits of the folded scale/offset
+
+enum SignalEndian
+{
+  BigEndian,                                // Motorola byte order, most significant byte first (MoTeC default)
+  LittleEndian                              // Intel byte order, least significant byte first
+};
+
+enum SignalUnit
+{
+  UNIT_NONE,                                // displayed in the unit it's transmitted in
+  UNIT_C_TO_F,                              // transmitted in celcius, displayed in farenheit
+  UNIT_KPA_TO_PSI,                          // transmitted in kPa, displayed in PSI
+  UNIT_KMH_TO_MPH                           // transmitted in km/h, displayed in mph
+};
+
+/**
+ * @brief Slope of a unit conversion, displayed = transmitted * unitFactor() + unitOffset()
+ *
+ */
+constexpr double unitFactor(SignalUnit unit)
+{
+  return unit == UNIT_C_TO_F      ? 9.0 / 5.0
+         : unit == UNIT_KPA_TO_PSI ? 0.1450377377
+         : unit == UNIT_KMH_TO_MPH ? 1.0 / 1.609344
+                                   : 1.0;
+}
+
+/**
+ * @brief Offset of a unit conversion, displayed = transmitted * unitFactor() + unitOffset()
+ *
+ */
+constexpr double unitOffset(SignalUnit unit)
+{
+  return unit == UNIT_C_TO_F ? 32.0 : 0.0;
+}
+
+/**
+ * @brief 10^decimals, for the fixed-point display representation
+ *
+ */
+constexpr double decimalScale(uint8_t decimals)
+{
+  return decimals == 0 ? 1.0 : 10.0 * decimalScale(decimals - 1);
+}
+
+/**
+ * @brief Rounds a compile-time double to the nearest Q24 integer
+ *
+ */
+constexpr int64_t toQ(double val)
+{
+  return (int64_t)(val * (1LL << SIGNAL_Q_BITS) + (val < 0 ? -0.5 : 0.5));
+}
+
+/**
+ * @brief Describes one channel packed into a CAN frame
+ *
+ * @tparam StartByte the lowest byte of the signal in msg.buf (the most significant byte for BigEndian, least for LittleEndian)
+ * @tparam BitLength number of bits in the signal, 1-32
+ * @tparam Endian byte order of the signal
+ * @tparam Signed true if the raw value is two's complement
+ * @tparam Multiplier C125 Dash Manager multiplier
+ * @tparam Divisor C125 Dash Manager divisor
+ * @tparam Adder C125 Dash Manager adder, applied after the multiplier and divisor
+ * @tparam Unit conversion from the transmitted unit to the displayed unit
+ * @tparam Decimals decimal places kept in value(), e.g. 2 returns 12.34 V as 1234
+ * @tparam BitOffset position of the signal's least significant bit within its bytes, for signals that aren't byte aligned
+ */
+template <uint8_t StartByte, uint8_t BitLength, SignalEndian Endian, bool Signed,
+          int32_t Multiplier = 1, int32_t Divisor = 1, int32_t Adder = 0, SignalUnit Unit = UNIT_NONE, uint8_t Decimals = 0, uint8_t BitOffset = 0>
+struct CANSignal
+{
+  static_assert(BitLength >= 1 && BitLength <= 32, "CANSignal: BitLength must be 1-32");
+  static_assert(Divisor != 0, "CANSignal: Divisor can't be 0");
+
+  static constexpr uint8_t byteCount = (BitOffset + BitLength + 7) / 8;
+  static_assert(byteCount <= 4, "CANSignal: signal can't span more than 4 bytes");
+  static_assert(StartByte + byteCount <= 8, "CANSignal: signal runs off the end of the frame");
+
+  static constexpr uint32_t mask = (BitLength == 32) ? 0xFFFFFFFFUL : ((1UL << BitLength) - 1);
+
+  /**
+   * @brief Assembles the signal's bytes, the loop is over a constant so it's fully unrolled
+   *
+   * @param buf msg.buf of the recieved frame
+   * @return int32_t the unscaled, sign-extended (if Signed) value
+   */
+  static inline int32_t raw(const uint8_t *buf)
+  {
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < byteCount; i++)
+    {
+      bits = (bits << 8) | buf[Endian == BigEndian ? StartByte + i : StartByte + byteCount - 1 - i];
+    }
+    bits = (bits >> BitOffset) & mask;
+
+    if (Signed && BitLength < 32)
+    {
+      return (int32_t)(bits << (32 - BitLength)) >> (32 - BitLength);
+    }
+    return (int32_t)bits;
+  }
+
+  /**
+   * @brief C125 scaling, unit conversion and decimal places folded into one Q24 slope and offset
+   *
+   */
+  static constexpr int64_t scaleQ = toQ((double)Multiplier / Divisor * unitFactor(Unit) * decimalScale(Decimals));
+  static constexpr int64_t offsetQ = toQ((Adder * unitFactor(Unit) + unitOffset(Unit)) * decimalScale(Decimals));
+  static_assert((double)mask * (double)(scaleQ < 0 ? -scaleQ : scaleQ) < 4.0e18, "CANSignal: scaled value overflows the Q24 pipeline");
+
+  /**
+   * @brief Scales the raw value with the C125 multiplier/divisor/adder and converts it to the displayed unit,
+   * rounded to the nearest display step
+   *
+   * @param buf msg.buf of the recieved frame
+   * @return int32_t the signal's value in its displayed unit, multiplied by 10^Decimals
+   */
+  static inline int32_t value(const uint8_t *buf)
+  {
+    int64_t q = (int64_t)raw(buf) * scaleQ + offsetQ;
+    return (int32_t)((q + (1LL << (SIGNAL_Q_BITS - 1))) >> SIGNAL_Q_BITS); // round half up
+  }
+};
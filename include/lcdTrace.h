@@ -0,0 +1,60 @@
+#include <Arduino.h>
+
+/**
+ * @brief Live RPM / throttle / lambda trace on a Nextion waveform component (build with -D LCD_TRACE)
+ *
+ * chngParamVal() feeds every value of the traced paramCodes into traceSample(), which only accumulates them.
+ * traceTick() averages what came in once per waveform pixel (TRACE_PIXEL_HZ) and pushes one point per channel
+ * into a ring buffer, so a 1 kHz RPM frame costs the trace nothing extra. traceFlush() sends the ring out in
+ * batches of TRACE_BATCH points per channel as one addt transfer each, held to TRACE_BYTES_PER_S.
+ *
+ * The ring keeps the last TRACE_RING_SIZE pixels while the trace's page isn't shown, so the waveform comes up
+ * with some history after a page change instead of starting empty.
+ *
+ * HMI change: the DragMode page gets a waveform with 3 channels, height TRACE_HEIGHT, and the component id in
+ * TRACE_WAVEFORM_ID (build with -D TRACE_WAVEFORM_ID=n if the editor gave it another one). Lambda and throttle
+ * are drawn there, so DragMode's screenParams row leaves out their Lam / Thrt text fields (PARAMS_TRACED) and the
+ * page needs neither component. Moving the trace to another page means moving that exclusion with it.
+ *
+ * Without LCD_TRACE nothing is sampled or sent, the LCD link keeps its whole budget and DragMode shows Lam / Thrt
+ * as before, so the stock HMI, which has no waveform, works unchanged.
+ */
+
+#ifndef TRACE_SCREEN
+#define TRACE_SCREEN DragMode       // page with the waveform component
+#endif
+#ifndef TRACE_WAVEFORM_ID
+#define TRACE_WAVEFORM_ID 20        // component id of the waveform in the HMI
+#endif
+#define TRACE_HEIGHT 255            // waveform height in pixels, points are 0 - TRACE_HEIGHT
+#define TRACE_CHANNELS 3
+#define TRACE_PIXEL_HZ 25           // points per second per channel, the waveform's scroll rate
+#define TRACE_RING_SIZE 64          // pixels of history kept, must be a power of 2
+#define TRACE_BATCH 8               // points per addt, at most NEXTION_ADDT_MAX
+#define TRACE_ADDT_OVERHEAD 16      // bytes of "addt 20,0,8" + terminator, rounded up
+#define TRACE_BYTES_PER_S 256       // share of the LCD link the trace may use
+
+struct TraceChannel
+{
+  uint8_t paramCode;                        // chngParamVal() paramCode feeding the channel
+  int32_t min;                              // value drawn at the bottom of the waveform
+  int32_t max;                              // value drawn at the top of the waveform
+  int32_t sum;                              // values recieved in the current pixel
+  uint16_t count;
+  uint8_t last;                             // last point, repeated when no value arrived during a pixel
+  uint8_t ring[TRACE_RING_SIZE];
+};
+
+TraceChannel traceChannels[TRACE_CHANNELS] = {
+    {10, 0, 14000},                         // ch 0 RPM
+    {11, 0, 10000},                         // ch 1 throttle, hundredths of a %
+    {7, 50, 150},                           // ch 2 lambda, hundredths
+};
+
+uint32_t traceHead;                         // pixels pushed into the rings
+uint32_t traceTail;                         // pixels sent to the LCD
+uint32_t traceOverwritten;                  // pixels lost to the ring wrapping before they were sent
+
+void traceSample(int paramCode, int val);
+void traceTick();
+void traceFlush();
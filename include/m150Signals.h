@@ -0,0 +1,30 @@
+#pragma once
+
+#include <canSignal.h>
+
+/**
+ * @brief MoTeC M150 dash broadcast, CAN IDs and channel layouts as set up in the C125 Dash Manager
+ *
+ * Adding a channel is one CANSignal<> line here and one registerCANDecoder() line in initCANDispatch().
+ */
+
+#define M150_ID_ENGINE 0x640        // RPM, MAP
+#define M150_ID_FUEL 0x641          // lambda, fuel pressure
+#define M150_ID_THROTTLE 0x642      // throttle pedal
+#define M150_ID_OIL_PRESSURE 0x644  // oil pressure
+#define M150_ID_WHEELSPEED 0x648    // all-drive wheelspeed
+#define M150_ID_TEMPS 0x649         // coolant temp, oil temp, battery voltage
+#define M150_ID_GEAR 0x64D          // gear position
+
+// CANSignal<StartByte, BitLength, Endian, Signed, Multiplier, Divisor, Adder, Unit, Decimals, BitOffset>
+using M150_RPM         = CANSignal<0, 16, BigEndian, false, 1, 1, 0>;
+using M150_MAP         = CANSignal<2, 16, BigEndian, false, 1, 10, 0>;                          // 0.1 kPa
+using M150_Lambda      = CANSignal<2, 16, BigEndian, false, 1, 100, 0, UNIT_NONE, 2>;           // 0.01 LA
+using M150_FuelPSR     = CANSignal<4, 16, BigEndian, false, 1, 10, 0, UNIT_KPA_TO_PSI>;         // 0.1 kPa
+using M150_Throttle    = CANSignal<0, 16, BigEndian, false, 1, 10, 0, UNIT_NONE, 2>;            // 0.1 %
+using M150_OilPSR      = CANSignal<6, 16, BigEndian, false, 1, 10, 0, UNIT_KPA_TO_PSI>;         // 0.1 kPa
+using M150_WheelSpeed  = CANSignal<6, 16, BigEndian, false, 1, 10, 0, UNIT_KMH_TO_MPH>;         // 0.1 km/h
+using M150_ECT         = CANSignal<0, 8, BigEndian, false, 1, 1, -40, UNIT_C_TO_F>;             // 1 C, -40 offset
+using M150_OilTemp     = CANSignal<1, 8, BigEndian, false, 1, 1, -40, UNIT_C_TO_F>;             // 1 C, -40 offset
+using M150_Battery     = CANSignal<5, 8, BigEndian, false, 1, 10, 0, UNIT_NONE, 2>;             // 0.1 V
+using M150_GearP       = CANSignal<6, 3, BigEndian, false, 1, 1, 0, UNIT_NONE, 0, 0>;           // low 3 bits, sign is extended from bit 3
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Allocation-free Nextion command formatting
+ *
+ * Every command is rendered into a fixed buffer on the caller's stack (never an Arduino String), with the
+ * 0xFF 0xFF 0xFF terminator appended, and goes out to the LCD as a single Serial1.write(buf, len).
+ *
+ * Component prefixes ("RPM.val=", "Batt.txt=", ...) are passed in as-is, so they can live in flash (PROGMEM).
+ * The txt formatters add the surrounding quotes themselves.
+ */
+
+#define NEXTION_CMD_MAX 48          // longest command incl. terminator, "timer_Delta.txt=\"-35791:23\"" is 29
+#define NEXTION_TERMINATOR 0xFF     // sent 3 times at the end of every command
+
+/**
+ * @brief UART link negotiation, see nextionNegotiateBaud()
+ *
+ */
+#define NEXTION_DEFAULT_BAUD 9600   // rate the LCD comes up at after a power cycle (its bauds= setting)
+#define NEXTION_BAUD_SETTLE_MS 50   // time the LCD needs to switch rates after a baud= command
+#define NEXTION_REPLY_TIMEOUT_MS 100 // longest wait for the reply to a get
+#define NEXTION_RET_NUMBER 0x71     // first byte of the LCD's reply to a numeric get
+
+/**
+ * @brief Non-blocking LCD transmit queue
+ *
+ * nextionWrite() only copies the command into a ring of whole commands and never waits on Serial1.
+ * nextionTxPump(), called from loop(), hands queued commands to Serial1's interrupt driven LPUART buffer, and only
+ * once there's room for the whole command, so Serial1.write() never blocks and a command is never half-sent.
+ *
+ * Commands can carry a key (the paramCode). A queued command is replaced in place by a newer one with the same
+ * key, and when the queue is full a new command is dropped whole. Only loop() touches the queue, never an ISR.
+ */
+#define NEXTION_TX_DEPTH 32         // commands the queue holds, a whole page replay (page, ref_stop, 17 params, ref_star) has to fit
+#define NEXTION_TX_SERIAL_MEM 256   // extra Serial1 TX buffer handed to the core with addMemoryForWrite()
+#define NEXTION_KEY_NONE 0xFF       // command isn't replaced by later commands (page changes, gets, ...)
+#define NEXTION_TP_TIMEOUT_MS 100   // longest wait for the LCD's 0xFE / 0xFD during a transparent transfer
+#define NEXTION_ADDT_MAX 32         // most points in one addt, the command and its data share one queue slot
+
+struct NextionTxStats
+{
+  uint8_t depth;                    // commands queued right now
+  uint8_t highWater;                // deepest the queue has been
+  uint32_t replaced;                // queued commands overwritten by a newer command for the same key
+  uint32_t dropped;                 // commands thrown away because the queue was full
+  uint32_t transparentTimeouts;     // addt transfers the LCD never asked for the data of, or never finished
+};
+
+extern NextionTxStats nextionTxStats;
+
+/**
+ * @brief Non-blocking parser for what the LCD sends back
+ *
+ * nextionRxPoll() reads whatever Serial1 has recieved and splits it into 0xFF 0xFF 0xFF terminated frames
+ * (numeric 0x71 replies are a fixed 8 bytes, since their value can contain 0xFF). Once nextionEnableAcks() has
+ * set bkcmd=3 the LCD answers every command with 0x01 or an error code, so each command handed to Serial1 is
+ * timestamped and matched with its answer to measure how far behind the LCD is.
+ */
+#define NEXTION_RX_MAX 32           // longest frame kept, longer ones are thrown away
+#define NEXTION_INFLIGHT_MAX 32     // commands waiting on an answer that are timed
+#define NEXTION_ACK_TIMEOUT_MS 500  // a command with no answer after this long is counted as lost
+
+#define NEXTION_RET_INVALID_CMD 0x00
+#define NEXTION_RET_OK 0x01
+#define NEXTION_RET_INVALID_VAR 0x1A
+#define NEXTION_RET_BUFFER_OVERFLOW 0x24
+#define NEXTION_RET_STRING 0x70
+#define NEXTION_RET_TRANSPARENT_READY 0xFE
+#define NEXTION_RET_TRANSPARENT_DONE 0xFD
+#define NEXTION_RET_TOUCH 0x65
+#define NEXTION_RET_PAGE 0x66
+#define NEXTION_RET_SLEEP 0x86
+#define NEXTION_RET_WAKE 0x87
+#define NEXTION_RET_READY 0x88
+
+struct NextionRxStats
+{
+  uint32_t acks;                    // 0x01 command OK
+  uint32_t errors;                  // any other command error, mostly 0x1A invalid variable
+  uint32_t overflows;               // 0x24, the LCD's serial input buffer overran
+  uint32_t timeouts;                // commands never answered within NEXTION_ACK_TIMEOUT_MS
+  uint32_t events;                  // frames that aren't answers to a command (touch, sleep, ready, ...)
+  uint32_t garbage;                 // bytes thrown away without ever making a frame
+  uint32_t latencySum;              // ms between handing a command to Serial1 and its answer, summed
+  uint32_t latencyCount;
+  uint8_t lastError;                // return code of the last error
+};
+
+extern NextionRxStats nextionRxStats;
+
+uint8_t nextionFormatRaw(char *buf, const char *cmd);
+uint8_t nextionFormatInt(char *buf, const char *prefix, int32_t val);
+uint8_t nextionFormatFixedTxt(char *buf, const char *prefix, int32_t val, uint8_t decimals);
+uint8_t nextionFormatTimeTxt(char *buf, const char *prefix, uint32_t msec);
+uint8_t nextionFormatAddt(char *buf, uint8_t objId, uint8_t channel, uint8_t qty);
+
+void nextionTxBegin();
+bool nextionTxFull(uint8_t key);
+uint8_t nextionTxFree();
+void nextionTxClear();
+void nextionTxPump();
+void nextionTxDrain();
+bool nextionWrite(const char *buf, uint8_t len, uint8_t key = NEXTION_KEY_NONE);
+bool nextionWriteTransparent(const char *buf, uint8_t len, const uint8_t *data, uint8_t dataLen, uint8_t key);
+void nextionEnableAcks();
+void nextionRxPoll();
+void nextionSendRaw(const char *cmd);
+void nextionSendInt(const char *prefix, int32_t val);
+void nextionSendFixedTxt(const char *prefix, int32_t val, uint8_t decimals);
+void nextionSendTimeTxt(const char *prefix, uint32_t msec);
+bool nextionSendAddt(uint8_t objId, uint8_t channel, const uint8_t *data, uint8_t qty);
+
+bool nextionProbe(uint32_t baud);
+void nextionSetBaud(uint32_t from, uint32_t to);
+uint32_t nextionNegotiateBaud(uint32_t lastGood);
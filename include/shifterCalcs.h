@@ -1,17 +1,50 @@
 #define analogOutputPin A16         // Digital Pin 40
 
-unsigned int shiftRatio;  
-const float gear1 = 0.002490845;     
+/**
+ * @brief Wheelspeed / RPM of each gear, in mph per RPM
+ *
+ */
+const float gear1 = 0.002490845;
 const float gear2 = 0.003216934;
 const float gear3 = 0.003859545;
 const float gear4 = 0.004455593;
 const float gear5 = 0.005003002;
-const float gear6 = 0.005594663;   
+const float gear6 = 0.005594663;
 
-const float t12 = (gear2-gear1)/2;
-const float t23 = (gear2-gear3)/2;
-const float t34 = (gear3-gear4)/2;
-const float t45 = (gear4-gear5)/2;
-const float t56 = (gear5-gear6)/2;
+/**
+ * @brief Gear estimator, works out the gear from the wheelspeed / RPM ratio for the M150's gear input
+ *
+ * The ratio is kept in fixed point, raw 0x648 wheelspeed (0.1 km/h) << 16 / RPM, so a frame costs one integer
+ * divide. The gear is found by a binary search over the midpoints between neighbouring gears, shifted up by
+ * GEAR_EST_HYST_PCT of the gap to move up a gear and down by as much to move down, so a ratio sitting on a midpoint
+ * doesn't flip between the two. From neutral, or with no estimate yet, there's no gear to hold and the plain
+ * midpoints decide. A new gear also has to hold for GEAR_EST_DWELL_MS before it's output, which rides out clutch
+ * slip and the ratio swinging through the other gears during a shift. A ratio outside every gear's band (clutch in,
+ * wheelspin) or RPM too low to mean anything keeps the last estimate.
+ */
+#define GEAR_RATIO_Q(ratio) ((uint32_t)((ratio) * 10 * 1.609344 * 65536 + 0.5)) // mph/RPM to the fixed-point ratio
+#define GEAR_EST_GEARS 6
+#define GEAR_EST_HYST_PCT 25        // of the gap between two gears' ratios
+#define GEAR_EST_DWELL_MS 150       // a new gear must hold this long (3 wheelspeed frames at 50ms) before it's output
+#define GEAR_EST_MIN_RPM 1500       // below this the engine's idling or stalling, the ratio means nothing
+#define GEAR_EST_STOPPED 30         // raw wheelspeed (0.1 km/h) below which the car is stopped, estimated as neutral
+#define GEAR_EST_UNKNOWN 0xFF
+#define GEAR_OUT_STEP 42            // analogWrite() level per gear (255 / 6), neutral is 0
 
-void checkShiftRatio();
\ No newline at end of file
+const uint32_t gearRatioQ[GEAR_EST_GEARS] = {GEAR_RATIO_Q(gear1), GEAR_RATIO_Q(gear2), GEAR_RATIO_Q(gear3),
+                                             GEAR_RATIO_Q(gear4), GEAR_RATIO_Q(gear5), GEAR_RATIO_Q(gear6)};
+
+uint32_t gearMidQ[GEAR_EST_GEARS - 1];      // midpoint between gear i + 1 and i + 2, decides with no gear to hold
+uint32_t gearUpQ[GEAR_EST_GEARS - 1];       // ratio above gearUpQ[i] is at least gear i + 2
+uint32_t gearDownQ[GEAR_EST_GEARS - 1];     // ratio below gearDownQ[i] is at most gear i + 1
+uint32_t gearRatioMinQ;                     // outside these no gear fits
+uint32_t gearRatioMaxQ;
+
+uint8_t estGear = GEAR_EST_UNKNOWN;         // gear last output on analogOutputPin, 0 = neutral
+uint8_t estGearCandidate = GEAR_EST_UNKNOWN;
+uint32_t estGearCandidateSince;             // millis() the candidate first showed up
+
+void initGearEstimator();
+uint8_t gearBelow(const uint32_t *bounds, uint32_t ratioQ);
+uint8_t classifyGear(uint32_t ratioQ, uint8_t current);
+void estimateGear(int speedRaw, int rpm, uint32_t now);
@@ -30,5 +30,189 @@
  */
 unsigned int gears[6] = {7000, 13600, 13000, 12500, 12200, 12200};
 
+/**
+ * @brief Predictive shift light, the white LED comes on when RPM is projected to reach the gear's shift point
+ * within the driver's reaction time, instead of once it already has
+ *
+ * dRPM/dt is a least-squares fit over the last RPM_HISTORY samples of the current gear, the history restarts on
+ * every gear change so the fit never spans a shift, and the projection uses the measured slope so each gear's own
+ * acceleration sets how early the light comes on. shiftReaction[] is the lead per gear (same indexing as gears[]),
+ * set SHIFT_REACTION_MS to 0 to go back to comparing instantaneous RPM.
+ * The RPM mailbox ISR only stores each sample, the fit and the LEDs run from decodeRPM() in loop().
+ */
+#ifndef SHIFT_REACTION_MS
+#define SHIFT_REACTION_MS 200       // driver reaction plus LED/LCD latency the light fires ahead by
+#endif
+#define RPM_HISTORY 8               // samples in the slope fit, 10ms RPM frames make it the last 80ms
+#define RPM_HISTORY_MIN 4           // fewer samples than this (right after a gear change) don't predict
+#define RPM_SAMPLE_MIN_US 2000      // an RPM read sooner than this after the last sample replaces it (a burst of frames)
+#define RPM_HISTORY_GAP_US 50000    // no RPM for this long (5 frames) and the history starts over, old samples would skew the slope
+#define SHIFT_MAX_LEAD_RPM 1500     // furthest ahead of the shift point the projection can fire, caps a noisy slope
+
+unsigned int shiftReaction[6] = {SHIFT_REACTION_MS, SHIFT_REACTION_MS, SHIFT_REACTION_MS,
+                                 SHIFT_REACTION_MS, SHIFT_REACTION_MS, SHIFT_REACTION_MS};
+
+struct RPMSample
+{
+  uint32_t usec;                            // micros() the RPM was read
+  int rpm;
+};
+
+RPMSample rpmHistory[RPM_HISTORY];          // ring, newest at rpmHistoryHead
+uint8_t rpmHistoryHead;
+uint8_t rpmHistoryCount;
+int rpmHistoryGear;                         // gear the samples belong to
+volatile bool shiftLightOn;                 // last checkRPM() lit the shift light, the LCD's shift flag follows it
+
+/**
+ * @brief Per-gear LED thresholds, precomputed from gears[] by initTachThresholds() so checkRPM() is a few compares
+ *
+ * Indexed by currGearP masked to its 3 bits, so every value the gear position can hold has an entry (0 = neutral,
+ * gears above 6th, which the M150 never sends, reuse 6th's). gears[] has no entry for 6th, it shares 5th's.
+ */
+#define GEAR_SLOTS 8                // every value of the 3 bit gear position
+#define GEAR_MASK (GEAR_SLOTS - 1)
+#define TACH_STEPS 4                // shift point split into quarters, one LED per quarter
+
+struct TachThresholds
+{
+  int step[TACH_STEPS - 1];                 // upper RPM of the G, GO and GOR quarters: shift point / 4 * 1..3
+  int shift;                                // gears[] shift point
+  uint32_t leadUs;                          // shiftReaction[] in micros
+};
+
+TachThresholds tachThresholds[GEAR_SLOTS];
+
+/**
+ * @brief Bit of each LED in its GPIO port, all four are on GPIO7, so the on/off LEDs are written with one store to
+ * GPIO7_DR_SET and one to GPIO7_DR_CLEAR instead of a digitalWrite() each (the bits also name the LEDs in patterns)
+ *
+ */
+#define TACH_BIT_G CORE_PIN34_BITMASK
+#define TACH_BIT_O CORE_PIN35_BITMASK
+#define TACH_BIT_R CORE_PIN36_BITMASK
+#define TACH_BIT_W CORE_PIN37_BITMASK
+#define TACH_BITS (TACH_BIT_G | TACH_BIT_O | TACH_BIT_R | TACH_BIT_W)
+#define TACH_PATTERN_UNKNOWN 0xFFFFFFFF     // forces the next write, the LEDs were last set with digitalWrite()
+
+/**
+ * @brief LEDs lit (bits set) for each number of thresholds RPM is past, past the 3rd quarter stays GOR like before
+ *
+ */
+const uint32_t tachPatterns[TACH_STEPS + 1] = {
+    0,                                      // RPM 0, engine off
+    TACH_BIT_G,
+    TACH_BIT_G | TACH_BIT_O,
+    TACH_BIT_G | TACH_BIT_O | TACH_BIT_R,
+    TACH_BIT_G | TACH_BIT_O | TACH_BIT_R,
+};
+#define TACH_PATTERN_SHIFT TACH_BIT_W       // shift now: the bar goes dark except the white LED
+
+volatile uint32_t tachPattern = TACH_PATTERN_UNKNOWN; // LEDs currently lit, ledAnimTimer writes it too
+volatile uint32_t tachRPMPattern;                     // what checkRPM() wants lit, shown once an animation ends
+
+/**
+ * @brief LED brightness, blink and fade engine
+ *
+ * On the Teensy 4.1 only LED_R (36) and LED_W (37) have a PWM output (FlexPWM2 submodule 3, B and A), so those two
+ * are lit through hardware PWM at a per-LED brightness, LED_G and LED_O (34, 35) stay plain on/off GPIO.
+ * FlexPWM can't run slower than ~18 Hz, too fast to see as a blink, so blinks and fades are stepped by ledAnimTimer
+ * (the same PIT interrupt as the animations), which only runs while something is blinking, fading or animating.
+ * loop() does nothing more than write the registers when the bar changes, with interrupts off so it can't
+ * interleave with the timer's writes. No other ISR touches the LEDs.
+ */
+#define TACH_PWM_HZ 2000            // both PWM LEDs share a submodule, so one frequency for both
+#define TACH_PWM_RES 8              // analogWriteResolution(), set once in setup() for every analogWrite()
+#define TACH_PWM_OFF 256            // analogWrite() value that holds the pin high (LED off) the whole period
+#define TACH_BRIGHTNESS_FULL 255
+#define TACH_OVERREV_RPM 300        // this far past the shift point the shift light starts blinking
+#define TACH_OVERREV_BLINK_MS 80    // on and off time of the over-rev blink
+#define TACH_FADE_MS 300            // day/night brightness change
+#define TACH_GPIO_BITS (TACH_BIT_G | TACH_BIT_O)
+
+enum TachLEDIndex {TACH_G, TACH_O, TACH_R, TACH_W, TACH_LED_COUNT};
+
+struct TachLED
+{
+  uint8_t pin;
+  uint32_t bit;                             // TACH_BIT_*
+  bool pwm;                                 // has a FlexPWM output, brightness only applies to these
+};
+
+const TachLED tachLEDs[TACH_LED_COUNT] = {
+    {LED_G, TACH_BIT_G, false},
+    {LED_O, TACH_BIT_O, false},
+    {LED_R, TACH_BIT_R, true},
+    {LED_W, TACH_BIT_W, true},
+};
+
+const uint8_t tachDayBrightness[TACH_LED_COUNT] = {255, 255, 255, 255};
+const uint8_t tachNightBrightness[TACH_LED_COUNT] = {255, 255, 60, 40}; // G and O can't dim
+
+volatile uint8_t tachLevel[TACH_LED_COUNT];  // brightness the PWM LEDs light at right now
+uint8_t tachFadeTarget[TACH_LED_COUNT];
+uint8_t tachFadeStep[TACH_LED_COUNT];       // brightness change per LED_ANIM_TICK_MS
+volatile uint32_t tachBlinkBits;            // TACH_BIT_* of the LEDs blinking
+uint32_t tachBlinkDark;                     // the blinking LEDs that are in their off half
+uint16_t tachBlinkMs;                       // on and off time
+uint16_t tachBlinkElapsed;
+bool ledTimerRunning;                       // ledAnimTimer started
+
+/**
+ * @brief Non-blocking LED animations, a list of keyframes (LEDs lit + how long) stepped by ledAnimTimer, which also
+ * steps the blinks and fades above
+ *
+ * The timer runs the animation in the background, so nothing waits on it: CAN, the LCD link and the boot
+ * animation all start together in setup(). While an animation is playing it owns the bar, checkRPM() only
+ * remembers its pattern, and the first non-zero RPM cancels it so the tach is never late for a running engine.
+ */
+#define LED_ANIM_TICK_MS 10         // keyframe durations are rounded up to this
+
+struct LEDKeyframe
+{
+  uint32_t pattern;                         // TACH_BIT_* lit
+  uint16_t ms;                              // how long it's shown
+};
+
+/**
+ * @brief Key-on sequence, fill the bar, flash the white LED twice, empty it again (same timing as the old blocking
+ * flashyOnSequence(), minus its 1s pause at the end)
+ *
+ */
+const LEDKeyframe bootAnimation[] = {
+    {0, 100},
+    {TACH_BIT_G, 90},
+    {TACH_BIT_G | TACH_BIT_O, 90},
+    {TACH_BIT_G | TACH_BIT_O | TACH_BIT_R, 90},
+    {TACH_BITS, 80},
+    {TACH_BIT_G | TACH_BIT_O | TACH_BIT_R, 80},
+    {TACH_BITS, 80},
+    {TACH_BIT_G | TACH_BIT_O | TACH_BIT_R, 90},
+    {TACH_BIT_G | TACH_BIT_O, 90},
+    {TACH_BIT_G, 90},
+};
+#define BOOT_ANIMATION_FRAMES (sizeof(bootAnimation) / sizeof(bootAnimation[0]))
+
+IntervalTimer ledAnimTimer;
+const LEDKeyframe *ledAnim;                 // animation playing, nullptr when none is
+uint8_t ledAnimFrames;
+uint8_t ledAnimStep;                        // keyframe being shown
+uint16_t ledAnimStepMs;                     // how long it has been shown
+
 void flashyOnSequence();
+void startLEDAnimation(const LEDKeyframe *frames, uint8_t count);
+void stopLEDAnimation();
+void ledAnimationTick();
+void initTachThresholds();
+void writeTachLEDs(uint32_t pattern);
+void applyTachLEDs();
+void initTachPWM(bool night);
+void setTachNightMode(bool night);
+void setTachBlink(uint32_t bits, uint16_t ms);
+bool tachEffectsTick();
+void startLEDTimer();
+void recordRPM(int rpm, int gear);
+int32_t rpmSlope();
+int projectedRPM(uint32_t leadUs);
+bool shiftDue(int gear);
 void checkRPM();
\ No newline at end of file
@@ -0,0 +1,386 @@
+/**
+ * @file dashBench.cpp
+ * @brief Runs the unmodified dashboard firmware on Linux against recorded or synthetic M150 traffic and reports
+ * what the decode-to-LCD-bytes path costs per CAN frame
+ *
+ * Build and run with PlatformIO:
+ *
+ *     pio run -e native
+ *     .pio/build/native/program [options] [candump.log]
+ *
+ * Without a log, a synthetic M150 dash broadcast is generated (RPM sweeping through the shift points, pedal,
+ * lambda, pressures, temps, gear, and a few IDs the dash doesn't decode). A log is read in candump -L format, "(1600000000.123456) can0 640#1F4003E8",
+ * and replayed on its own timestamps.
+ *
+ * Each frame goes in through Can0.inject(), which calls the firmware's onReceive() handler like the ISR would,
+ * and is followed by one loop(). Only inject() + loop() are timed, on the host's steady clock. The firmware's
+ * clock is virtual and follows the traffic, so rate limits, LCD frame pacing and the UART drain behave as they
+ * would on the car while the run itself goes as fast as the host can.
+ *
+ * The LCD is played by a model that answers every command straight away (0x01, or 0x71 for a get, 0xFE / 0xFD
+ * for addt), so the ack tracking and adaptive rate see a healthy display.
+ *
+ * Options:
+ *     --frames N          synthetic frames to generate (default 100000)
+ *     --page N            press the page button N times after setup (Params -> Config1 -> Config2 -> DragMode)
+ *     --capture FILE      write everything sent to Serial1 as a timestamped capture for tools/nextionEmulator
+ *     --quiet             don't echo the firmware's Serial prints
+ *
+ * Left out of pio test -e native builds, the test runner brings its own main().
+ */
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <nextionCommand.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#define BENCH_DEFAULT_FRAMES 100000
+#define BENCH_CAPTURE_MAGIC "NXCAP1\n"      // see tools/nextionEmulator
+#define BENCH_PAGE_BTN_PIN A17              // pgBtnPin in NextionLCD.h
+#define BENCH_PAGE_BTN_PRESSED 1023
+#define BENCH_PAGE_BTN_GAP_US 400000        // longer than PAGE_BTN_DEBOUNCE_MS between presses
+
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
+void setup();
+void loop();
+
+/**
+ * @brief A frame and when it goes on the bus
+ *
+ */
+struct BenchFrame
+{
+  uint64_t usec;
+  CAN_message_t msg;
+};
+
+/**
+ * @brief Synthetic M150 dash broadcast, one entry per ID
+ *
+ */
+struct BenchSchedule
+{
+  uint32_t id;
+  uint16_t periodMs;
+};
+
+const BenchSchedule benchSchedule[] = {
+    {0x640, 10},                            // RPM, MAP
+    {0x641, 20},                            // lambda, fuel pressure
+    {0x642, 20},                            // throttle pedal
+    {0x644, 50},                            // oil pressure
+    {0x648, 20},                            // wheelspeed
+    {0x649, 100},                           // temps, battery
+    {0x64D, 20},                            // gear
+    {0x643, 20},                            // the rest have no decoder, they show what the acceptance filters keep out
+    {0x645, 50},
+    {0x64A, 100},
+    {0x64F, 50},
+};
+
+static FILE *captureFile;
+static uint8_t lcdCmd[64];                  // command the LCD model is recieving
+static uint8_t lcdCmdLen;
+static uint8_t lcdTermCount;
+static uint32_t lcdDataRemaining;           // transparent bytes still owed after an addt
+
+static void put16(uint8_t *buf, uint16_t val)
+{
+  buf[0] = val >> 8;
+  buf[1] = val & 0xFF;
+}
+
+/**
+ * @brief Builds the payload of a synthetic frame at time t, every channel moves so nothing is suppressed as
+ * unchanged for long
+ *
+ */
+static void synthFrame(CAN_message_t &msg, uint32_t id, uint32_t ms)
+{
+  uint32_t sweep = ms % 8000;               // 8 s pull through the gears
+  memset(msg.buf, 0, sizeof(msg.buf));
+  msg.id = id;
+  msg.len = 8;
+
+  switch (id)
+  {
+  case 0x640:
+    put16(msg.buf, 3000 + sweep * 10000 / 8000);       // RPM
+    put16(msg.buf + 2, 300 + sweep / 8);                // MAP, 0.1 kPa
+    break;
+  case 0x641:
+    put16(msg.buf + 2, 850 + (ms / 20) % 300);          // lambda, 0.001 LA
+    put16(msg.buf + 4, 3500 + (ms / 100) % 200);        // fuel pressure, 0.1 kPa
+    break;
+  case 0x642:
+    put16(msg.buf, sweep < 7000 ? 1000 : 0);            // throttle pedal, 0.1 %
+    break;
+  case 0x644:
+    put16(msg.buf + 6, 3000 + sweep / 4);               // oil pressure, 0.1 kPa
+    break;
+  case 0x648:
+    put16(msg.buf + 6, sweep / 4);                      // wheelspeed, 0.1 km/h
+    break;
+  case 0x649:
+    msg.buf[0] = 40 + 85 + (ms / 10000) % 10;           // ECT, C + 40
+    msg.buf[1] = 40 + 100;                              // oil temp, C + 40
+    msg.buf[5] = 138 - (ms / 5000) % 5;                 // battery, 0.1 V
+    break;
+  case 0x64D:
+    msg.buf[6] = 1 + sweep / 1600;                      // gear
+    break;
+  }
+}
+
+static void synthTraffic(std::vector<BenchFrame> &frames, uint32_t count)
+{
+  for (uint32_t ms = 0; frames.size() < count; ms++)
+  {
+    for (const BenchSchedule &s : benchSchedule)
+    {
+      if (ms % s.periodMs == 0 && frames.size() < count)
+      {
+        BenchFrame f;
+        f.usec = (uint64_t)ms * 1000;
+        synthFrame(f.msg, s.id, ms);
+        frames.push_back(f);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Reads a candump -L log, lines that don't parse are skipped
+ *
+ */
+static bool loadCandump(const char *path, std::vector<BenchFrame> &frames)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+  {
+    return false;
+  }
+
+  char line[256];
+  double firstTs = -1;
+  while (fgets(line, sizeof(line), f))
+  {
+    double ts;
+    char iface[32], idStr[16], data[40] = "";
+    if (sscanf(line, " (%lf) %31s %15[0-9A-Fa-f]#%39s", &ts, iface, idStr, data) < 3)
+    {
+      continue;
+    }
+    if (firstTs < 0)
+    {
+      firstTs = ts;
+    }
+
+    BenchFrame frame;
+    frame.usec = (uint64_t)((ts - firstTs) * 1e6);
+    frame.msg.id = strtoul(idStr, nullptr, 16);
+    frame.msg.flags.extended = strlen(idStr) > 3; // candump writes standard IDs as 3 digits, extended as 8
+    frame.msg.len = 0;
+    for (size_t i = 0; data[i] && data[i + 1] && frame.msg.len < 8; i += 2)
+    {
+      unsigned int byte;
+      sscanf(data + i, "%2x", &byte);
+      frame.msg.buf[frame.msg.len++] = byte;
+    }
+    frames.push_back(frame);
+  }
+  fclose(f);
+  return true;
+}
+
+static void lcdReply(uint8_t code)
+{
+  const uint8_t reply[4] = {code, 0xFF, 0xFF, 0xFF};
+  nativeSerialInject(Serial1, reply, sizeof(reply));
+}
+
+/**
+ * @brief LCD model, sees every byte written to Serial1 and answers like a display with bkcmd=3
+ *
+ */
+static void lcdModel(const uint8_t *buf, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    if (lcdDataRemaining > 0)
+    {
+      if (--lcdDataRemaining == 0)
+      {
+        lcdReply(NEXTION_RET_TRANSPARENT_DONE);
+      }
+      continue;
+    }
+
+    lcdTermCount = (buf[i] == NEXTION_TERMINATOR) ? lcdTermCount + 1 : 0;
+    if (buf[i] != NEXTION_TERMINATOR && lcdCmdLen < sizeof(lcdCmd) - 1)
+    {
+      lcdCmd[lcdCmdLen++] = buf[i];
+    }
+    if (lcdTermCount < 3)
+    {
+      continue;
+    }
+
+    lcdCmd[lcdCmdLen] = 0;
+    unsigned int objId, channel, qty;
+    if (sscanf((const char *)lcdCmd, "addt %u,%u,%u", &objId, &channel, &qty) == 3)
+    {
+      lcdDataRemaining = qty;
+      lcdReply(NEXTION_RET_TRANSPARENT_READY);
+    }
+    else if (strncmp((const char *)lcdCmd, "get ", 4) == 0)
+    {
+      const uint8_t number[8] = {NEXTION_RET_NUMBER, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF};
+      nativeSerialInject(Serial1, number, sizeof(number));
+    }
+    else if (lcdCmdLen > 0)
+    {
+      lcdReply(NEXTION_RET_OK);
+    }
+    lcdCmdLen = 0;
+    lcdTermCount = 0;
+  }
+
+  if (captureFile)
+  {
+    uint32_t usec = micros();
+    uint16_t n = len;
+    const uint8_t header[6] = {(uint8_t)usec, (uint8_t)(usec >> 8), (uint8_t)(usec >> 16), (uint8_t)(usec >> 24),
+                               (uint8_t)n, (uint8_t)(n >> 8)};
+    fwrite(header, 1, sizeof(header), captureFile);
+    fwrite(buf, 1, len, captureFile);
+  }
+}
+
+static void pressPageButton()
+{
+  nativeAdvanceMicros(BENCH_PAGE_BTN_GAP_US);
+  nativeSetPin(BENCH_PAGE_BTN_PIN, BENCH_PAGE_BTN_PRESSED);
+  nativeFireInterrupt(BENCH_PAGE_BTN_PIN); // press, the next loop() changes the page
+  nativeFireInterrupt(BENCH_PAGE_BTN_PIN); // still held, debounced
+  nativeSetPin(BENCH_PAGE_BTN_PIN, 0);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t frameCount = BENCH_DEFAULT_FRAMES;
+  uint32_t pages = 0;
+  const char *logPath = nullptr;
+  const char *capturePath = nullptr;
+  Serial.echo = true;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+    {
+      frameCount = strtoul(argv[++i], nullptr, 0);
+    }
+    else if (!strcmp(argv[i], "--page") && i + 1 < argc)
+    {
+      pages = strtoul(argv[++i], nullptr, 0);
+    }
+    else if (!strcmp(argv[i], "--capture") && i + 1 < argc)
+    {
+      capturePath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--quiet"))
+    {
+      Serial.echo = false;
+    }
+    else if (argv[i][0] != '-')
+    {
+      logPath = argv[i];
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--frames N] [--page N] [--capture FILE] [--quiet] [candump.log]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<BenchFrame> frames;
+  if (logPath ? !loadCandump(logPath, frames) : (synthTraffic(frames, frameCount), false))
+  {
+    fprintf(stderr, "can't read %s\n", logPath);
+    return 1;
+  }
+  if (frames.empty())
+  {
+    fprintf(stderr, "no frames\n");
+    return 1;
+  }
+
+  if (capturePath)
+  {
+    captureFile = fopen(capturePath, "wb");
+    if (!captureFile)
+    {
+      fprintf(stderr, "can't write %s\n", capturePath);
+      return 1;
+    }
+    fwrite(BENCH_CAPTURE_MAGIC, 1, strlen(BENCH_CAPTURE_MAGIC), captureFile);
+  }
+
+  Serial1.txHook = lcdModel;
+  setup();
+  for (uint32_t i = 0; i < pages; i++)
+  {
+    pressPageButton();
+    loop();
+  }
+
+  uint64_t bootUs = micros();
+  uint64_t bytesBefore = Serial1.bytesWritten;
+  std::vector<uint32_t> frameNs;
+  frameNs.reserve(frames.size());
+  uint64_t totalNs = 0;
+
+  for (BenchFrame &f : frames)
+  {
+    nativeSetMicros(bootUs + f.usec);
+
+    auto start = std::chrono::steady_clock::now();
+    Can0.inject(f.msg);
+    loop();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    frameNs.push_back((uint32_t)ns);
+    totalNs += ns;
+  }
+
+  if (captureFile)
+  {
+    fclose(captureFile);
+  }
+
+  uint64_t lcdBytes = Serial1.bytesWritten - bytesBefore;
+  std::sort(frameNs.begin(), frameNs.end());
+  size_t n = frameNs.size();
+
+  printf("\nframes              %zu (%s)\n", n, logPath ? logPath : "synthetic");
+  printf("virtual time        %.2f s\n", (micros() - bootUs) / 1e6);
+  printf("LCD link            %u baud\n", Serial1.baud);
+  printf("ns/frame            mean %llu  p50 %u  p99 %u  max %u\n", (unsigned long long)(totalNs / n),
+         frameNs[n / 2], frameNs[n * 99 / 100], frameNs[n - 1]);
+  printf("LCD bytes           %llu (%.2f/frame)\n", (unsigned long long)lcdBytes, (double)lcdBytes / n);
+  printf("ns/LCD byte         %.1f\n", lcdBytes ? (double)totalNs / lcdBytes : 0.0);
+  printf("CAN filtered        %u\n", Can0.filtered);
+  printf("CAN interrupts      %u (%.0f/s, build with -D CAN_ACCEPT_ALL for the unfiltered rate)\n", Can0.wakeups,
+         Can0.wakeups * 1e6 / (micros() - bootUs));
+  printf("TX queue            high water %u  replaced %u  dropped %u\n", nextionTxStats.highWater,
+         nextionTxStats.replaced, nextionTxStats.dropped);
+  printf("LCD answers         acks %u  errors %u  timeouts %u\n", nextionRxStats.acks, nextionRxStats.errors,
+         nextionRxStats.timeouts);
+  return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,184 @@
+#pragma once
+
+/**
+ * @brief Host (Linux) stand-in for the parts of the Teensyduino core the dashboard uses, for [env:native]
+ *
+ * Only what src/ actually calls is here. Time is virtual: millis()/micros() only move when the driver calls
+ * nativeAdvanceMicros() (or the firmware calls delay(), or yield() in a busy wait), so a replay runs as fast as the
+ * host can go and is repeatable run to run.
+ *
+ * Serial1 keeps what the firmware writes in memory instead of sending it, and drains its TX buffer at the
+ * configured baud in virtual time, so availableForWrite() backs up the same way the LPUART does.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+
+#define HEX 16
+#define DEC 10
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+#define RISING 2
+#define FALLING 3
+#define CHANGE 4
+
+#define A16 40
+#define A17 41
+#define NATIVE_PIN_COUNT 64
+
+#define PROGMEM
+#define FLASHMEM
+#define FASTRUN
+#define DMAMEM
+
+#define F_CPU 600000000
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+/**
+ * @brief GPIO7 set/clear registers for the Teensy 4.1 pins the tach LEDs are on, a store lands on those pins'
+ * nativePinOutput() like the matching digitalWrite()s would
+ *
+ */
+#define CORE_PIN34_BITMASK (1UL << 29)
+#define CORE_PIN35_BITMASK (1UL << 28)
+#define CORE_PIN36_BITMASK (1UL << 18)
+#define CORE_PIN37_BITMASK (1UL << 19)
+
+struct NativeGPIOWrite
+{
+  uint8_t level;                            // what a set bit drives its pin to
+  void operator=(uint32_t bits);
+};
+
+extern NativeGPIOWrite GPIO7_DR_SET;
+extern NativeGPIOWrite GPIO7_DR_CLEAR;
+
+#define ARM_DWT_CYCCNT (nativeCycleCount()) // only BENCH_CONVERSIONS reads it, ticks at F_CPU off the host clock
+
+// templates rather than the core's macros, so they don't collide with std::numeric_limits<>::max() in host headers
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+
+/**
+ * @brief Serial port that writes into memory
+ *
+ * txHook, when set, sees every byte the firmware writes, in order (the driver uses it to play the LCD).
+ * Bytes for the firmware to read are queued with nativeSerialInject().
+ */
+class HardwareSerial
+{
+public:
+  void begin(uint32_t baud);
+  void end() {}
+  void flush();
+  void clear();
+  explicit operator bool() { return true; }
+
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t len);
+  size_t write(const char *buf, size_t len) { return write((const uint8_t *)buf, len); }
+  int availableForWrite();
+  void addMemoryForWrite(void *buf, size_t len) { txSize += len; }
+  void addMemoryForRead(void *buf, size_t len) {}
+
+  int available();
+  int read();
+
+  size_t print(const char *str);
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long val, int base = DEC);
+  size_t print(unsigned long val, int base = DEC);
+  size_t print(int val, int base = DEC) { return print((long)val, base); }
+  size_t print(unsigned int val, int base = DEC) { return print((unsigned long)val, base); }
+  size_t print(double val, int digits = 2);
+  size_t println() { return print("\r\n"); }
+  template <typename T>
+  size_t println(T val) { return print(val) + println(); }
+  template <typename T>
+  size_t println(T val, int fmt) { return print(val, fmt) + println(); }
+
+  uint32_t baud = 0;
+  uint32_t txSize = 64;                     // LPUART TX buffer, grows with addMemoryForWrite()
+  uint32_t txUsed = 0;                      // bytes written but not yet on the wire
+  uint32_t txDrainedAt = 0;                 // micros() the drain was last brought up to date
+  uint64_t bytesWritten = 0;
+  bool echo = false;                        // copy writes to stdout (Serial prints, off for Serial1)
+  void (*txHook)(const uint8_t *buf, size_t len) = nullptr;
+
+  uint8_t rx[1024];
+  uint16_t rxHead = 0;
+  uint16_t rxTail = 0;
+
+private:
+  void drain();
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+/**
+ * @brief Periodic "interrupt", its callback runs whenever virtual time passes one of its periods, in order with
+ * any other timer's
+ *
+ */
+#define NATIVE_TIMER_COUNT 4        // PIT channels on the Teensy 4.1
+
+class IntervalTimer
+{
+public:
+  bool begin(void (*func)(), unsigned int usec);
+  void end();
+  void update(unsigned int usec) { periodUs = usec; }
+  void priority(uint8_t n) {}
+
+  void (*callback)() = nullptr;
+  uint32_t periodUs = 0;
+  uint64_t nextUs = 0;                      // virtual time of the next call
+};
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t msec);
+void delayMicroseconds(uint32_t usec);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+void analogWriteFrequency(uint8_t pin, float freq);
+void analogWriteResolution(uint32_t bits);
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+void noInterrupts();
+void interrupts();
+
+/**
+ * @brief Driver side of the shim, not part of the Arduino API
+ *
+ */
+uint32_t nativeCycleCount();
+void nativeAdvanceMicros(uint32_t usec);
+void nativeSetMicros(uint64_t usec);
+void nativeSerialInject(HardwareSerial &port, const uint8_t *buf, size_t len);
+void nativeSetPin(uint8_t pin, int val);    // what digitalRead()/analogRead() return for the pin
+int nativePinOutput(uint8_t pin);           // last digitalWrite()/analogWrite() to the pin
+bool nativeFireInterrupt(uint8_t pin);      // runs the pin's attachInterrupt() handler, false if there isn't one
+extern uint8_t nativeISRDepth;              // > 0 while an IntervalTimer, pin or CAN handler runs
+extern uint32_t nativeISRUnmasks;           // interrupts() calls from inside a handler, on the Teensy these unmask every
+                                            // other interrupt early, or the caller's critical section if it had one
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define NATIVE_EEPROM_SIZE 4284     // Teensy 4.1 emulated EEPROM
+
+/**
+ * @brief RAM-backed EEPROM, starts erased (0xFF) every run like a freshly flashed Teensy
+ *
+ */
+struct EEPROMClass
+{
+  uint8_t mem[NATIVE_EEPROM_SIZE];
+
+  EEPROMClass() { memset(mem, 0xFF, sizeof(mem)); }
+
+  uint8_t read(int addr) { return mem[addr]; }
+  void write(int addr, uint8_t val) { mem[addr] = val; }
+  void update(int addr, uint8_t val) { mem[addr] = val; }
+
+  template <typename T>
+  T &get(int addr, T &t)
+  {
+    memcpy(&t, mem + addr, sizeof(T));
+    return t;
+  }
+
+  template <typename T>
+  const T &put(int addr, const T &t)
+  {
+    memcpy(mem + addr, &t, sizeof(T));
+    return t;
+  }
+};
+
+extern EEPROMClass EEPROM;
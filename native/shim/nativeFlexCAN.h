@@ -0,0 +1,364 @@
+#pragma once
+
+/**
+ * @brief Host (Linux) stand-in for FlexCAN_T4, for [env:native]
+ *
+ * Force-included ahead of every source file (-include in platformio.ini). It defines the real library's include
+ * guard, so the vendored include/FlexCAN_T4.h, which needs the i.MX RT registers, is skipped wherever src/ includes
+ * it and the firmware compiles unmodified.
+ *
+ * Only the configuration calls the dashboard makes are modelled, and only as far as deciding where a frame goes:
+ * inject() routes a frame the way the controller would (RX mailbox filters, FIFO filter table, setMRP priority)
+ * and runs the handlers right away, like the ISR would: the mailbox's (or the FIFO's) own onReceive() handler,
+ * then the global one, both for the same frame as FlexCAN_T4's mbCallbacks() does.
+ *
+ * Range and multi-ID filters are a base ID and a mask in hardware, so like on the chip they wake the CPU for every
+ * ID the mask lets through (0x641-0x642, or 0x641 and 0x642, wakes for 0x640-0x643). FlexCAN_T4's ISR then drops
+ * the IDs the filter didn't ask for before any handler runs; wakeups counts the interrupts, so both are visible.
+ */
+
+#define _FLEXCAN_T4_H_
+
+#include "Arduino.h"
+
+typedef struct CAN_message_t
+{
+  uint32_t id = 0;
+  uint16_t timestamp = 0;
+  uint8_t idhit = 0;
+  struct
+  {
+    bool extended = 0;
+    bool remote = 0;
+    bool overrun = 0;
+    bool reserved = 0;
+  } flags;
+  uint8_t len = 8;
+  uint8_t buf[8] = {0};
+  int8_t mb = 0;
+  uint8_t bus = 0;
+  bool seq = 0;
+} CAN_message_t;
+
+typedef void (*_MB_ptr)(const CAN_message_t &msg);
+
+typedef enum FLEXCAN_MAILBOX
+{
+  MB0, MB1, MB2, MB3, MB4, MB5, MB6, MB7, MB8, MB9, MB10, MB11, MB12, MB13, MB14, MB15,
+  FIFO = 99
+} FLEXCAN_MAILBOX;
+
+typedef enum FLEXCAN_RXTX { TX, RX, LISTEN_ONLY } FLEXCAN_RXTX;
+typedef enum FLEXCAN_IDE { NONE = 0, EXT = 1, RTR = 2, STD = 3, INACTIVE } FLEXCAN_IDE;
+typedef enum FLEXCAN_FLTEN { ACCEPT_ALL = 0, REJECT_ALL = 1 } FLEXCAN_FLTEN;
+typedef enum FLEXCAN_RFFN_TABLE { RFFN_8, RFFN_16, RFFN_24, RFFN_32, RFFN_40, RFFN_48, RFFN_56, RFFN_64,
+                                  RFFN_72, RFFN_80, RFFN_88, RFFN_96, RFFN_104, RFFN_112, RFFN_120, RFFN_128 } FLEXCAN_RFFN_TABLE;
+typedef enum FLEXCAN_RXQUEUE_TABLE { RX_SIZE_2 = 2, RX_SIZE_16 = 16, RX_SIZE_256 = 256 } FLEXCAN_RXQUEUE_TABLE;
+typedef enum FLEXCAN_TXQUEUE_TABLE { TX_SIZE_2 = 2, TX_SIZE_16 = 16, TX_SIZE_256 = 256 } FLEXCAN_TXQUEUE_TABLE;
+typedef enum CAN_DEV_TABLE { CAN1, CAN2, CAN3 } CAN_DEV_TABLE;
+
+#define NATIVE_CAN_MB_COUNT 16
+#define NATIVE_CAN_MB_IDS 5         // most IDs setMBFilter() takes
+#define NATIVE_CAN_FIFO_FILTERS 128 // RFFN_128
+
+/**
+ * @brief One acceptance rule, either up to NATIVE_CAN_MB_IDS exact IDs or an inclusive range
+ *
+ */
+struct NativeCANFilter
+{
+  uint32_t ids[NATIVE_CAN_MB_IDS];
+  uint8_t count;                            // 0 rejects everything
+  bool range;                               // ids[0]..ids[1] inclusive
+  bool acceptAll;
+  bool extended;
+
+  bool matches(const CAN_message_t &msg) const
+  {
+    if (acceptAll)
+    {
+      return true;
+    }
+    if (count == 0 || msg.flags.extended != extended)
+    {
+      return false;
+    }
+    if (range)
+    {
+      return msg.id >= ids[0] && msg.id <= ids[1];
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+      if (ids[i] == msg.id)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief What the controller's ID/mask compare accepts, a superset of matches() for ranges and multi-ID filters
+   *
+   */
+  bool wakes(const CAN_message_t &msg) const
+  {
+    if ((!range && count < 2) || acceptAll || msg.flags.extended != extended)
+    {
+      return matches(msg);
+    }
+    uint32_t ored = ids[0];
+    uint32_t anded = ids[0];
+    uint32_t last = range ? ids[1] : count - 1;
+    for (uint32_t i = range ? ids[0] + 1 : 1; i <= last; i++)
+    {
+      uint32_t id = range ? i : ids[i];
+      ored |= id;
+      anded &= id;
+    }
+    uint32_t mask = ~(ored ^ anded) & (extended ? 0x1FFFFFFF : 0x7FF); // same mask FlexCAN_T4 programs
+    return ((msg.id ^ ids[0]) & mask) == 0;
+  }
+
+  void set(uint32_t id1, uint32_t id2, uint8_t n, bool isRange, bool ext)
+  {
+    ids[0] = id1;
+    ids[1] = id2;
+    count = n;
+    range = isRange;
+    acceptAll = false;
+    extended = ext;
+  }
+};
+
+template <CAN_DEV_TABLE _bus, FLEXCAN_RXQUEUE_TABLE _rxSize = RX_SIZE_16, FLEXCAN_TXQUEUE_TABLE _txSize = TX_SIZE_16>
+class FlexCAN_T4
+{
+public:
+  void begin() {}
+  void setBaudRate(uint32_t baud = 1000000, FLEXCAN_RXTX listen_only = TX) {}
+  void setMaxMB(uint8_t last) { maxMB = last > NATIVE_CAN_MB_COUNT ? NATIVE_CAN_MB_COUNT : last; }
+  void enableFIFO(bool status = 1) { fifoEnabled = status; }
+  void enableFIFOInterrupt(bool status = 1) { fifoInterrupt = status; }
+  void mailboxStatus() {}
+  void setMRP(bool mrp = 1) { mailboxFirst = mrp; }
+
+  void onReceive(_MB_ptr handler) { mainHandler = handler; }
+  void onReceive(const FLEXCAN_MAILBOX &mb_num, _MB_ptr handler)
+  {
+    if (mb_num == FIFO)
+    {
+      fifoHandler = handler;
+    }
+    else if (mb_num < NATIVE_CAN_MB_COUNT)
+    {
+      mbHandler[mb_num] = handler;
+    }
+  }
+
+  bool setMB(const FLEXCAN_MAILBOX &mb_num, const FLEXCAN_RXTX &mb_rx_tx, const FLEXCAN_IDE &ide = STD)
+  {
+    if (mb_num >= maxMB)
+    {
+      return false;
+    }
+    mbRx[mb_num] = (mb_rx_tx == RX);
+    mbFilter[mb_num] = NativeCANFilter();
+    mbFilter[mb_num].acceptAll = true;
+    return true;
+  }
+  void enableMBInterrupt(const FLEXCAN_MAILBOX &mb_num, bool status = 1) { mbInterrupt[mb_num] = status; }
+  void enableMBInterrupts(bool status = 1)
+  {
+    for (uint8_t mb = 0; mb < NATIVE_CAN_MB_COUNT; mb++)
+    {
+      mbInterrupt[mb] = status;
+    }
+  }
+
+  void setMBFilter(FLEXCAN_FLTEN input)
+  {
+    for (uint8_t mb = 0; mb < NATIVE_CAN_MB_COUNT; mb++)
+    {
+      setMBFilter((FLEXCAN_MAILBOX)mb, input);
+    }
+  }
+  void setMBFilter(FLEXCAN_MAILBOX mb_num, FLEXCAN_FLTEN input)
+  {
+    mbFilter[mb_num] = NativeCANFilter();
+    mbFilter[mb_num].acceptAll = (input == ACCEPT_ALL);
+  }
+  bool setMBFilter(FLEXCAN_MAILBOX mb_num, uint32_t id1) { return setMBIds(mb_num, id1, 0, 0, 0, 0, 1); }
+  bool setMBFilter(FLEXCAN_MAILBOX mb_num, uint32_t id1, uint32_t id2) { return setMBIds(mb_num, id1, id2, 0, 0, 0, 2); }
+  bool setMBFilter(FLEXCAN_MAILBOX mb_num, uint32_t id1, uint32_t id2, uint32_t id3) { return setMBIds(mb_num, id1, id2, id3, 0, 0, 3); }
+  bool setMBFilterRange(FLEXCAN_MAILBOX mb_num, uint32_t id1, uint32_t id2)
+  {
+    if (mb_num >= maxMB || id1 > id2)
+    {
+      return false;
+    }
+    mbFilter[mb_num].set(id1, id2, 2, true, false);
+    return true;
+  }
+
+  uint8_t setRFFN(FLEXCAN_RFFN_TABLE rffn = RFFN_8)
+  {
+    fifoFilterCount = (rffn + 1) * 8;
+    return 6 + ((rffn + 1) * 2);            // first mailbox left after the filter table
+  }
+  void setFIFOFilter(const FLEXCAN_FLTEN &input)
+  {
+    fifoAcceptAll = (input == ACCEPT_ALL);
+    for (uint8_t i = 0; i < NATIVE_CAN_FIFO_FILTERS; i++)
+    {
+      fifoFilter[i] = NativeCANFilter();
+    }
+  }
+  bool setFIFOFilter(uint8_t filter, uint32_t id1, const FLEXCAN_IDE &ide, const FLEXCAN_IDE &remote = NONE)
+  {
+    return setFIFOIds(filter, id1, 0, 1, false, ide);
+  }
+  bool setFIFOFilter(uint8_t filter, uint32_t id1, uint32_t id2, const FLEXCAN_IDE &ide, const FLEXCAN_IDE &remote = NONE)
+  {
+    return setFIFOIds(filter, id1, id2, 2, false, ide);
+  }
+  bool setFIFOFilterRange(uint8_t filter, uint32_t id1, uint32_t id2, const FLEXCAN_IDE &ide, const FLEXCAN_IDE &remote = NONE)
+  {
+    return id1 <= id2 && setFIFOIds(filter, id1, id2, 2, true, ide);
+  }
+
+  uint64_t events() { return 0; }
+  uint32_t getRXQueueCount() { return 0; }
+  uint32_t getTXQueueCount() { return 0; }
+  int write(const CAN_message_t &msg) { return 1; }
+
+  /**
+   * @brief Hands a frame to the controller as if it had just come off the bus
+   *
+   * @param msg the frame, id/flags/len/buf are used
+   * @return true if a mailbox or the FIFO accepted it (its handler has run if that interrupt is enabled)
+   */
+  bool inject(CAN_message_t msg)
+  {
+    int8_t mb = -1;
+    for (uint8_t i = 0; i < maxMB && mb < 0; i++)
+    {
+      if (mbRx[i] && mbFilter[i].wakes(msg))
+      {
+        mb = i;
+      }
+    }
+
+    int16_t filter = -1;
+    bool fifoMatch = false;                 // FlexCAN_T4's software check over the whole table
+    if (fifoEnabled)
+    {
+      for (uint8_t i = 0; i < fifoFilterCount; i++)
+      {
+        if (filter < 0 && fifoFilter[i].wakes(msg))
+        {
+          filter = i;
+        }
+        fifoMatch |= fifoFilter[i].matches(msg);
+      }
+      if (filter < 0 && fifoAcceptAll)
+      {
+        filter = 0;
+        fifoMatch = true;
+      }
+    }
+
+    msg.timestamp = (uint16_t)micros();
+    if (mb >= 0 && (mailboxFirst || filter < 0))
+    {
+      msg.mb = mb;
+      if (mbInterrupt[mb])
+      {
+        wakeups++;
+        if (mbFilter[mb].matches(msg))
+        {
+          nativeISRDepth++;
+          callHandlers(mbHandler[mb], msg);
+          nativeISRDepth--;
+        }
+      }
+      return true;
+    }
+    if (filter >= 0)
+    {
+      msg.mb = FIFO;
+      msg.idhit = filter;
+      if (fifoInterrupt && (fifoHandler || mainHandler))
+      {
+        wakeups++;
+        if (fifoMatch)
+        {
+          nativeISRDepth++;
+          callHandlers(fifoHandler, msg);
+          nativeISRDepth--;
+        }
+      }
+      return true;
+    }
+    filtered++;
+    return false;
+  }
+
+  uint32_t filtered = 0;                    // frames inject() found no mailbox or FIFO filter for
+  uint32_t wakeups = 0;                     // frames that woke the CPU, including range-mask extras no handler sees
+
+private:
+  /**
+   * @brief Same order as FlexCAN_T4's mbCallbacks(), the mailbox's (or the FIFO's) own handler and then the global
+   * one, both run for every frame
+   *
+   */
+  void callHandlers(_MB_ptr handler, const CAN_message_t &msg)
+  {
+    if (handler)
+    {
+      handler(msg);
+    }
+    if (mainHandler)
+    {
+      mainHandler(msg);
+    }
+  }
+
+  bool setMBIds(FLEXCAN_MAILBOX mb_num, uint32_t id1, uint32_t id2, uint32_t id3, uint32_t id4, uint32_t id5, uint8_t count)
+  {
+    if (mb_num >= maxMB)
+    {
+      return false;
+    }
+    mbFilter[mb_num].set(id1, id2, count, false, false);
+    mbFilter[mb_num].ids[2] = id3;
+    mbFilter[mb_num].ids[3] = id4;
+    mbFilter[mb_num].ids[4] = id5;
+    return true;
+  }
+
+  bool setFIFOIds(uint8_t filter, uint32_t id1, uint32_t id2, uint8_t count, bool range, const FLEXCAN_IDE &ide)
+  {
+    if (filter >= fifoFilterCount)
+    {
+      return false;
+    }
+    fifoFilter[filter].set(id1, id2, count, range, ide == EXT);
+    return true;
+  }
+
+  uint8_t maxMB = NATIVE_CAN_MB_COUNT;
+  bool mbRx[NATIVE_CAN_MB_COUNT] = {};
+  bool mbInterrupt[NATIVE_CAN_MB_COUNT] = {};
+  NativeCANFilter mbFilter[NATIVE_CAN_MB_COUNT] = {};
+  _MB_ptr mbHandler[NATIVE_CAN_MB_COUNT] = {};
+  _MB_ptr mainHandler = nullptr;
+  _MB_ptr fifoHandler = nullptr;
+  bool mailboxFirst = false;
+  bool fifoEnabled = false;
+  bool fifoInterrupt = false;
+  bool fifoAcceptAll = true;
+  uint8_t fifoFilterCount = 8;
+  NativeCANFilter fifoFilter[NATIVE_CAN_FIFO_FILTERS] = {};
+};
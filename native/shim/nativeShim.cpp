@@ -0,0 +1,350 @@
+#include "Arduino.h"
+#include "EEPROM.h"
+
+#include <chrono>
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+EEPROMClass EEPROM;
+NativeGPIOWrite GPIO7_DR_SET = {HIGH};
+NativeGPIOWrite GPIO7_DR_CLEAR = {LOW};
+
+static uint64_t nativeMicros;               // virtual time, see nativeAdvanceMicros()
+uint8_t nativeISRDepth;
+uint32_t nativeISRUnmasks;
+static int pinInput[NATIVE_PIN_COUNT];
+static int pinOutput[NATIVE_PIN_COUNT];
+static void (*pinISR[NATIVE_PIN_COUNT])();
+static IntervalTimer *timers[NATIVE_TIMER_COUNT];
+
+/**
+ * @brief Moves virtual time forward to usec, running every IntervalTimer callback that falls due on the way at the
+ * time it was due
+ *
+ */
+static void advanceTo(uint64_t usec)
+{
+  while (true)
+  {
+    IntervalTimer *due = nullptr;
+    for (IntervalTimer *t : timers)
+    {
+      if (t && t->nextUs <= usec && (!due || t->nextUs < due->nextUs))
+      {
+        due = t;
+      }
+    }
+    if (!due)
+    {
+      break;
+    }
+    if (due->nextUs > nativeMicros)
+    {
+      nativeMicros = due->nextUs;
+    }
+    due->nextUs += due->periodUs;
+    nativeISRDepth++;
+    due->callback(); // may end() its own timer
+    nativeISRDepth--;
+  }
+  if (usec > nativeMicros)
+  {
+    nativeMicros = usec;
+  }
+}
+
+bool IntervalTimer::begin(void (*func)(), unsigned int usec)
+{
+  end();
+  for (IntervalTimer *&t : timers)
+  {
+    if (t == nullptr)
+    {
+      t = this;
+      callback = func;
+      periodUs = usec ? usec : 1;
+      nextUs = micros() + periodUs;
+      return true;
+    }
+  }
+  return false; // out of PIT channels
+}
+
+void IntervalTimer::end()
+{
+  for (IntervalTimer *&t : timers)
+  {
+    if (t == this)
+    {
+      t = nullptr;
+    }
+  }
+}
+
+uint32_t millis()
+{
+  return (uint32_t)(nativeMicros / 1000);
+}
+
+uint32_t micros()
+{
+  return (uint32_t)nativeMicros;
+}
+
+void delay(uint32_t msec)
+{
+  advanceTo(nativeMicros + (uint64_t)msec * 1000);
+}
+
+void delayMicroseconds(uint32_t usec)
+{
+  advanceTo(nativeMicros + usec);
+}
+
+void yield()
+{
+  advanceTo(nativeMicros + 1); // the firmware's busy waits yield() every pass, so a wait for a reply that never comes still times out
+}
+
+void nativeAdvanceMicros(uint32_t usec)
+{
+  advanceTo(nativeMicros + usec);
+}
+
+void nativeSetMicros(uint64_t usec)
+{
+  advanceTo(usec); // time never runs backwards, a late frame is just handled now
+}
+
+uint32_t nativeCycleCount()
+{
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+  return (uint32_t)(ns.count() * (F_CPU / 1000000) / 1000);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin < NATIVE_PIN_COUNT)
+  {
+    pinOutput[pin] = val;
+  }
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < NATIVE_PIN_COUNT ? (pinInput[pin] != 0) : 0;
+}
+
+int analogRead(uint8_t pin)
+{
+  return pin < NATIVE_PIN_COUNT ? pinInput[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+  if (pin < NATIVE_PIN_COUNT)
+  {
+    pinOutput[pin] = val; // not through digitalWrite(), 256 (always high at 8 bits) doesn't fit its uint8_t
+  }
+}
+
+void analogWriteFrequency(uint8_t pin, float freq) {}
+void analogWriteResolution(uint32_t bits) {}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode)
+{
+  if (pin < NATIVE_PIN_COUNT)
+  {
+    pinISR[pin] = isr;
+  }
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  attachInterrupt(pin, nullptr, 0);
+}
+
+void noInterrupts() {} // "interrupts" only ever run when the driver calls them, between loop()s
+void interrupts()
+{
+  if (nativeISRDepth != 0)
+  {
+    nativeISRUnmasks++;
+  }
+}
+
+void nativeSetPin(uint8_t pin, int val)
+{
+  if (pin < NATIVE_PIN_COUNT)
+  {
+    pinInput[pin] = val;
+  }
+}
+
+void NativeGPIOWrite::operator=(uint32_t bits)
+{
+  static const struct
+  {
+    uint8_t pin;
+    uint32_t bit;
+  } gpio7Pins[] = {{34, CORE_PIN34_BITMASK}, {35, CORE_PIN35_BITMASK}, {36, CORE_PIN36_BITMASK}, {37, CORE_PIN37_BITMASK}};
+
+  for (const auto &p : gpio7Pins)
+  {
+    if (bits & p.bit)
+    {
+      pinOutput[p.pin] = level;
+    }
+  }
+}
+
+int nativePinOutput(uint8_t pin)
+{
+  return pin < NATIVE_PIN_COUNT ? pinOutput[pin] : 0;
+}
+
+bool nativeFireInterrupt(uint8_t pin)
+{
+  if (pin >= NATIVE_PIN_COUNT || pinISR[pin] == nullptr)
+  {
+    return false;
+  }
+  nativeISRDepth++;
+  pinISR[pin]();
+  nativeISRDepth--;
+  return true;
+}
+
+void nativeSerialInject(HardwareSerial &port, const uint8_t *buf, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    uint16_t next = (port.rxHead + 1) % sizeof(port.rx);
+    if (next == port.rxTail)
+    {
+      return; // RX buffer overrun, the rest is lost like on the real UART
+    }
+    port.rx[port.rxHead] = buf[i];
+    port.rxHead = next;
+  }
+}
+
+void HardwareSerial::begin(uint32_t rate)
+{
+  baud = rate;
+  txUsed = 0;
+  txDrainedAt = micros();
+}
+
+/**
+ * @brief Takes the bytes the UART has shifted out since the last call off txUsed, 10 bits per byte
+ *
+ */
+void HardwareSerial::drain()
+{
+  uint32_t now = micros();
+  if (txUsed == 0 || baud == 0)
+  {
+    txUsed = 0;
+    txDrainedAt = now;
+    return;
+  }
+  uint32_t sent = (uint32_t)((uint64_t)(now - txDrainedAt) * baud / 10000000);
+  if (sent >= txUsed)
+  {
+    txUsed = 0;
+    txDrainedAt = now;
+  }
+  else if (sent)
+  {
+    txUsed -= sent;
+    txDrainedAt += (uint32_t)((uint64_t)sent * 10000000 / baud); // keeps the part of a byte that's still shifting out
+  }
+}
+
+void HardwareSerial::flush()
+{
+  drain();
+  if (txUsed && baud)
+  {
+    advanceTo(nativeMicros + (uint64_t)txUsed * 10000000 / baud); // blocks until the last byte is out
+  }
+  txUsed = 0;
+  txDrainedAt = micros();
+}
+
+void HardwareSerial::clear()
+{
+  rxTail = rxHead;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+  drain();
+  txUsed += len; // a full buffer would block the real write(), callers check availableForWrite() first
+  bytesWritten += len;
+  if (echo)
+  {
+    fwrite(buf, 1, len, stdout);
+  }
+  if (txHook)
+  {
+    txHook(buf, len);
+  }
+  return len;
+}
+
+int HardwareSerial::availableForWrite()
+{
+  drain();
+  return txUsed >= txSize ? 0 : txSize - txUsed;
+}
+
+int HardwareSerial::available()
+{
+  return (rxHead - rxTail + sizeof(rx)) % sizeof(rx);
+}
+
+int HardwareSerial::read()
+{
+  if (rxHead == rxTail)
+  {
+    return -1;
+  }
+  uint8_t c = rx[rxTail];
+  rxTail = (rxTail + 1) % sizeof(rx);
+  return c;
+}
+
+size_t HardwareSerial::print(const char *str)
+{
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t HardwareSerial::print(long val, int base)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%ld", val);
+  return print(buf);
+}
+
+size_t HardwareSerial::print(unsigned long val, int base)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", val);
+  return print(buf);
+}
+
+size_t HardwareSerial::print(double val, int digits)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", digits, val);
+  return print(buf);
+}
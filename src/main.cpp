@@ -1,5 +1,10 @@
 #include <Arduino.h>
+#include <EEPROM.h>
 #include <NextionLCD.h>
+#include <canDispatch.h>
+#include <lcdTrace.h>
+#include <m150Signals.h>
+#include <nextionCommand.h>
 #include <shifterCalcs.h>
 #include <tachometer.h>
 
@@ -14,16 +19,6 @@
 
 #warning TODO: Marv, add an instruction screen on how to use the dashboard, an idling (no ign) animation, and a demo mode
 
-/**
- * @brief Command that is required at the end of every serial message to the LCD to indicate the end of the command
- */
-void endCommand()
-{
-  Serial1.write(0xff);
-  Serial1.write(0xff);
-  Serial1.write(0xff);
-}
-
 /**
  * @brief Outputs the data of a CAN message recieved
  * Copied from the FlexCANT4 CAN2.0_example_FIFO_with_interrupts.ino example
@@ -54,461 +49,941 @@ void canSniff(const CAN_message_t &msg)
 }
 
 /**
- * @brief Outputs and analog signal to the MoTeC M150 (from 0-3.3V) indicating the
- * current gear of the vehicle based on the ratio of CurrentWheelSpeed / CurrentRPM
+ * @brief Fills the estimator's up/down bounds and band from gear1..gear6, call before CAN is started
+ *
+ */
+void initGearEstimator()
+{
+  for (uint8_t i = 0; i < GEAR_EST_GEARS - 1; i++)
+  {
+    uint32_t gap = gearRatioQ[i + 1] - gearRatioQ[i];
+    uint32_t mid = gearRatioQ[i] + gap / 2;
+    gearMidQ[i] = mid;
+    gearUpQ[i] = mid + gap * GEAR_EST_HYST_PCT / 100;
+    gearDownQ[i] = mid - gap * GEAR_EST_HYST_PCT / 100;
+  }
+  gearRatioMinQ = gearRatioQ[0] - (gearRatioQ[1] - gearRatioQ[0]) / 2;
+  gearRatioMaxQ = gearRatioQ[GEAR_EST_GEARS - 1] + (gearRatioQ[GEAR_EST_GEARS - 1] - gearRatioQ[GEAR_EST_GEARS - 2]) / 2;
+  estGear = GEAR_EST_UNKNOWN;
+  estGearCandidate = GEAR_EST_UNKNOWN;
+}
+
+/**
+ * @brief Binary search for how many of the ascending gear bounds the ratio has reached
+ *
+ * @param bounds gearUpQ or gearDownQ
+ * @return uint8_t 0 to GEAR_EST_GEARS - 1, one less than the gear
+ */
+uint8_t gearBelow(const uint32_t *bounds, uint32_t ratioQ)
+{
+  uint8_t lo = 0;
+  uint8_t hi = GEAR_EST_GEARS - 1;
+  while (lo < hi)
+  {
+    uint8_t mid = (lo + hi) / 2;
+    if (ratioQ >= bounds[mid])
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * @brief Gear the ratio belongs to, only moving off current once the ratio is past the hysteresis either side of
+ * the midpoint, with no current gear (neutral, or no estimate yet) the nearest gear by the midpoints
  *
- * @param ratio a floating point variable whose value is the CurrentWheelSpeed / CurrentRPM
+ * @param ratioQ fixed-point wheelspeed / RPM, inside gearRatioMinQ..gearRatioMaxQ
+ * @param current gear estimated so far, 0 or GEAR_EST_UNKNOWN when there isn't one
+ * @return uint8_t 1 to GEAR_EST_GEARS
  */
-void checkShiftRatio(long unsigned ratio)
+uint8_t classifyGear(uint32_t ratioQ, uint8_t current)
 {
-  float analogOut_ratio = 255 / 6;
-  if (ratio == 0)
+  if (current == 0 || current == GEAR_EST_UNKNOWN)
+  {
+    return gearBelow(gearMidQ, ratioQ) + 1;
+  }
+  uint8_t up = gearBelow(gearUpQ, ratioQ) + 1;
+  uint8_t down = gearBelow(gearDownQ, ratioQ) + 1; // never below up, the down bounds are the lower ones
+  if (up > current)
   {
-    Serial.print("Neutral");
-    analogWrite(analogOutputPin, 0);
+    return up;
   }
-  if (ratio >= gear1 - t12 || ratio < gear1 + t12)
+  if (down < current)
+  {
+    return down;
+  }
+  return current;
+}
+
+/**
+ * @brief Outputs an analog signal to the MoTeC M150 (from 0-3.3V) indicating the current gear of the vehicle based
+ * on the ratio of CurrentWheelSpeed / CurrentRPM, analogOutputPin is only written when the estimate changes
+ *
+ * @param speedRaw raw all-drive wheelspeed from 0x648 (0.1 km/h)
+ * @param rpm current engine RPM
+ * @param now getTime()
+ */
+void estimateGear(int speedRaw, int rpm, uint32_t now)
+{
+  uint8_t candidate;
+  if (speedRaw < GEAR_EST_STOPPED)
   {
-    Serial.print("Gear 1");
-    analogWrite(analogOutputPin, analogOut_ratio);
+    candidate = 0; // stopped, neutral
   }
-  if (ratio >= gear2 - t12 || ratio < gear2 + t23)
+  else if (rpm < GEAR_EST_MIN_RPM)
   {
-    Serial.print("Gear 2");
-    analogWrite(analogOutputPin, analogOut_ratio * 2);
+    return; // rolling with the engine idling, could be any gear with the clutch in
   }
-  if (ratio >= gear3 - t23 || ratio < gear3 + t34)
+  else
   {
-    Serial.print("Gear 3");
-    analogWrite(analogOutputPin, analogOut_ratio * 3);
+    uint32_t ratioQ = ((uint32_t)speedRaw << 16) / (uint32_t)rpm;
+    if (ratioQ < gearRatioMinQ || ratioQ > gearRatioMaxQ)
+    {
+      estGearCandidate = estGear; // slipping or mid-shift, whatever was building up doesn't count
+      return;
+    }
+    candidate = classifyGear(ratioQ, estGear);
   }
-  if (ratio >= gear4 - t34 || ratio < gear4 + t45)
+
+  if (candidate == estGear)
   {
-    Serial.print("Gear 4");
-    analogWrite(analogOutputPin, analogOut_ratio * 4);
+    estGearCandidate = estGear;
+    return;
   }
-  if (ratio >= gear5 - t45 || ratio < gear5 + t56)
+  if (candidate != estGearCandidate)
   {
-    Serial.print("Gear 5");
-    analogWrite(analogOutputPin, analogOut_ratio * 5);
+    estGearCandidate = candidate;
+    estGearCandidateSince = now;
+    return;
   }
-  if (ratio >= gear6 - t56 || ratio < gear6 + t56)
+  if (now - estGearCandidateSince < GEAR_EST_DWELL_MS)
   {
-    Serial.print("Gear 6");
-    analogWrite(analogOutputPin, analogOut_ratio);
+    return;
   }
+
+  estGear = candidate;
+  analogWrite(analogOutputPin, candidate * GEAR_OUT_STEP);
 }
 
 /**
- * @brief Reads ID of the latest CAN message, extracts its data, and sends updated parameter data to the LCD
- * Copied from the FlexCANT4 CAN2.0_example_FIFO_with_interrupts.ino example
+ * @brief Decodes engine RPM from CAN ID 0x640 and updates the tachometer lights
  *
  * @param msg the memory address of the CAN message recieved
  */
-void CANmsgRecieve(const CAN_message_t &msg)
+void decodeRPM(const CAN_message_t &msg)
 {
-  // canSniff(msg);
-
-  /* Redundant code to ensure flip flop of isSilentTime */
-  if (getTime() - timeHolder >= silenceTime)
+  currRPM = M150_RPM::raw(msg.buf);
+  if (bootTiming.firstRPM == BOOT_NOT_YET)
   {
-    isSilentTime = !isSilentTime;
-    timeHolder = getTime();
+    bootTiming.firstRPM = getTime();
   }
+  chngParamVal(10, (int)currRPM);
+  // Serial.println(currRPM);
+#if !CAN_FAST_PATH
+  recordRPM(currRPM, currGearP); // otherwise rpmFastPathRecieve() already has, stamped when the frame came in
+#endif
+  checkRPM();
+}
 
-  /*
-    if isSilentTime == false, process all CAN messages like normal
-    if isSilentTime == true, process the message if it's for GearP, otherwise return
-  */
-  if (isSilentTime == false)
+/**
+ * @brief Decodes manifold air pressure from CAN ID 0x640
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeMAP(const CAN_message_t &msg)
+{
+  currMAP = M150_MAP::value(msg.buf);
+  // Serial.println(currMAP);
+  chngParamVal(8, currMAP);
+}
+
+/**
+ * @brief Decodes fuel pressure from CAN ID 0x641 and raises/clears the FPRSR warning
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeFuelPressure(const CAN_message_t &msg)
+{
+  currFuelPSR = M150_FuelPSR::value(msg.buf);
+  chngParamVal(5, currFuelPSR);
+
+  if (currFuelPSR <= 38 && currRPM > 500) // raise FPRSR warning
+  {
+    chngParamVal(19, 1);
+  }
+  else
   {
-    if (currScreen != Params)
+    if (WARN_FPRSR == 1)
     {
+      chngParamVal(19, 0);
+    }
+  }
+}
 
-      if (msg.id == 1600) // CAN ID 0x640
-      {
+/**
+ * @brief Raises the "Slow Down" warning when fuel pressure drops past the critical limit
+ *
+ * @param msg the memory address of the CAN message recieved (CAN ID 0x641), already decoded by decodeFuelPressure()
+ */
+void checkFuelPressureSlowDown(const CAN_message_t &msg)
+{
+  if (currFuelPSR <= 35) // raise FPRSR warning + "Slow Down" screen
+  {
+    // chngScrnSlowDown();                         // can't call "chngScrn()" directly for some reason
+    chngParamVal(18, WARN_FPRSR);
+  }
+  else
+  {
+    // returnToLastNormScrn();
+  }
+}
 
-        currRPM = msg.buf[0];
-        currRPM = currRPM << 8;
-        currRPM |= msg.buf[1];
-        chngParamVal(10, (int)currRPM);
-        // Serial.println(currRPM);
-        checkRPM();
-      }
-      else if (msg.id == 1613) // CAN ID 0x64D
-      {
-        // lock code from executing other statements, return to updating gear pos
-
-        int mask = 0x0F;
-        int mask2 = 0b00000111; // 0000 0111 ; the sign is extended from bit 3
-        currGearP = msg.buf[6];
-        currGearP &= mask;
-        currGearP &= mask2;
-        chngParamVal(6, currGearP);
-      }
-      else if (msg.id == 1609) // CAN ID 0x649
-      {
-        currECT = msg.buf[0];
-        currECT = ((currECT * 10) - 400) / 10; // from C125 Dash manager Multiplier, Divisor, and Adder
-        // The equations applied below convert the MoTeC celcius reading to farenheit
-        currECT = (currECT * 1.8) + 32;
-        chngParamVal(2, currECT);
-
-        currOilTemp = msg.buf[1];
-        currOilTemp = ((currOilTemp * 10) - 400) / 10; // from C125 Dash manager Multiplier, Divisor, and Adder
-        // The equations applied below convert the MoTeC celcius reading to farenheit
-        currOilTemp = (currOilTemp * 1.8) + 32;
-        chngParamVal(22, currOilTemp);
-
-        if (currECT >= 220) // raise ECTO warning
-        {
-          chngParamVal(18, 1);
-        }
-        else
-        {
-          if (WARN_ECTO == 1)
-          {
-            chngParamVal(18, 0);
-          }
-        }
+/**
+ * @brief Decodes engine lambda from CAN ID 0x641
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeLambda(const CAN_message_t &msg)
+{
+  // using engine efficiency
+  currLamb = M150_Lambda::value(msg.buf);
+  chngParamVal(7, currLamb);
+}
 
-        if (currOilTemp >= 220) // raise OTEMP warning
-        {
-          chngParamVal(20, 1);
-        }
-        else
-        {
-          if (WARN_OTEMP == 1)
-          {
-            chngParamVal(20, 0);
-          }
-        }
-      }
-      else if (msg.id == 1604) // CAN ID 0x644
-      {
-        currOilPSR = msg.buf[6];
-        currOilPSR = currOilPSR << 8;
-        currOilPSR |= msg.buf[7];
-        currOilPSR = (currOilPSR * 0.145038) / 10; // kPA to PSI conversion
-        chngParamVal(9, currOilPSR);
+/**
+ * @brief Decodes throttle pedal position from CAN ID 0x642
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeThrottle(const CAN_message_t &msg)
+{
+  currThrtl = M150_Throttle::value(msg.buf);
+  chngParamVal(11, currThrtl);
+}
 
-        if (currRPM > 500) // raise OPRSR warning
-        {
-          if ((currOilPSR <= 25 && currRPM >= 3000) || (currOilPSR <= 45 && currRPM >= 6000) || (currOilPSR <= 50 && currRPM >= 7000))
-          {
-            chngParamVal(21, 1);
-          }
-          else
-          {
-            chngParamVal(21, 0);
-          }
-        }
-      }
-      else if (msg.id == 1601) // CAN ID 0x641
-      {
-        currFuelPSR = msg.buf[4];
-        currFuelPSR = currFuelPSR << 8;
-        currFuelPSR |= msg.buf[5];
-        currFuelPSR = (currFuelPSR * 0.145038) / 10; // kPA to PSI conversion
-        chngParamVal(5, currFuelPSR);
+/**
+ * @brief Decodes oil pressure from CAN ID 0x644 and raises/clears the OPRSR warning
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeOilPressure(const CAN_message_t &msg)
+{
+  currOilPSR = M150_OilPSR::value(msg.buf);
+  chngParamVal(9, currOilPSR);
 
-        if (currFuelPSR <= 38 && currRPM > 500) // raise FPRSR warning
-        {
-          chngParamVal(19, 1);
-        }
-        else
-        {
-          if (WARN_FPRSR == 1)
-          {
-            chngParamVal(19, 0);
-          }
-        }
-      }
+  if (currRPM > 500) // raise OPRSR warning
+  {
+    if ((currOilPSR <= 25 && currRPM >= 3000) || (currOilPSR <= 45 && currRPM >= 6000) || (currOilPSR <= 50 && currRPM >= 7000))
+    {
+      chngParamVal(21, 1);
     }
     else
     {
-      if (msg.id == 1600) // CAN ID 0x640
-      {
-        currRPM = msg.buf[0];
-        currRPM = currRPM << 8;
-        currRPM |= msg.buf[1];
-        chngParamVal(10, (int)currRPM);
-
-        // Serial.println(currRPM);
-        checkRPM();
-      }
-      else if (msg.id == 1600) // CAN ID 0x640
-      {
-        currMAP = msg.buf[2];
-        currMAP = currMAP << 8;
-        currMAP |= msg.buf[3];
-        currMAP *= 0.1; // Base resolution for kPA from C125
-        // Serial.println(currMAP);
-        chngParamVal(8, currMAP);
-      }
-      else if (msg.id == 1609) // CAN ID 0x649
-      {
-        currECT = msg.buf[0];
-        currECT = ((currECT * 10) - 400) / 10; // from C125 Dash manager Multiplier, Divisor, and Adder
-        // The equations applied below convert the MoTeC celcius reading to farenheit
-        currECT = (currECT * 1.8) + 32;
-        chngParamVal(2, currECT);
-
-        currBatt = ((msg.buf[5]) * 10) / 100; // from C125 Dash manager Multiplier, Divisor, and Adder
-        chngParamVal(0, currBatt);
-
-        if (currECT >= 220) // raise ECTO warning
-        {
-          chngParamVal(18, 1);
-        }
-        else
-        {
-          if (WARN_ECTO == 1)
-          {
-            chngParamVal(18, 0);
-          }
-        }
-
-        if (currECT >= 240) // raise ECTO warning + "Slow Down" screen
-        {
-          // chngScrnSlowDown();                       // can't call "chngScrn()" directly for some reason
-          chngParamVal(18, WARN_ECTO);
-        }
-        else
-        {
-          returnToLastNormScrn();
-        }
-
-        currOilTemp = msg.buf[1];
-        currOilTemp = ((currOilTemp * 10) - 400) / 10; // from C125 Dash manager Multiplier, Divisor, and Adder
-        // The equations applied below convert the MoTeC celcius reading to farenheit
-        currOilTemp = (currOilTemp * 1.8) + 32;
-        chngParamVal(22, currOilTemp);
-
-        if (currOilTemp >= 220) // raise OTEMP warning
-        {
-          chngParamVal(20, 1);
-        }
-        else
-        {
-          if (WARN_OTEMP == 1)
-          {
-            chngParamVal(20, 0);
-          }
-        }
-
-        if (currOilTemp >= 240) // raise OTEMP warning + "Slow Down" screen
-        {
-          // chngScrnSlowDown();                       // can't call "chngScrn()" directly for some reason
-          chngParamVal(18, WARN_OTEMP);
-        }
-        else
-        {
-          returnToLastNormScrn();
-        }
-      }
-      else if (msg.id == 1604) // CAN ID 0x644
-      {
-        currOilPSR = msg.buf[6];
-        currOilPSR = currOilPSR << 8;
-        currOilPSR |= msg.buf[7];
-        currOilPSR = (currOilPSR * 0.145038) / 10; // kPA to PSI conversion
-        chngParamVal(9, currOilPSR);
-
-        if (currRPM > 500) // raise OPRSR warning
-        {
-          if ((currOilPSR <= 25 && currRPM >= 3000) || (currOilPSR <= 45 && currRPM >= 6000) || (currOilPSR <= 50 && currRPM >= 7000))
-          {
-            chngParamVal(21, 1);
-          }
-          else
-          {
-            chngParamVal(21, 0);
-          }
-
-          // raise ECTO warning + "Slow Down" screen
-          if ((currOilPSR <= 20 && currRPM >= 3000) || (currOilPSR <= 40 && currRPM >= 6000) || (currOilPSR <= 45 && currRPM >= 7000))
-          {
-            // chngScrnSlowDown();                       // can't call "chngScrn()" directly for some reason
-            chngParamVal(18, WARN_OPRSR);
-          }
-          else
-          {
-            // returnToLastNormScrn();
-          }
-        }
-      }
-      else if (msg.id == 1602) // CAN ID 0x642
-      {
-        int temp = msg.buf[0];
-        temp = temp << 8;
-        temp |= msg.buf[1];
-        currThrtl = temp * 0.1; // base resolution (multiplied by 100 because I need the percentage representation)
-        chngParamVal(11, currThrtl);
-      }
-      else if (msg.id == 1601) // CAN ID 0x641
-      {
-        currFuelPSR = msg.buf[4];
-        currFuelPSR = currFuelPSR << 8;
-        currFuelPSR |= msg.buf[5];
-        currFuelPSR = (currFuelPSR * 0.145038) / 10; // kPA to PSI conversion
-        chngParamVal(5, currFuelPSR);
-
-        if (currFuelPSR <= 38 && currRPM > 500) // raise FPRSR warning
-        {
-          chngParamVal(19, 1);
-        }
-        else
-        {
-          if (WARN_FPRSR == 1)
-          {
-            chngParamVal(19, 0);
-          }
-        }
-
-        if (currFuelPSR <= 35) // raise FPRSR warning + "Slow Down" screen
-        {
-          // chngScrnSlowDown();                         // can't call "chngScrn()" directly for some reason
-          chngParamVal(18, WARN_FPRSR);
-        }
-        else
-        {
-          // returnToLastNormScrn();
-        }
+      chngParamVal(21, 0);
+    }
+  }
+}
 
-        // using engine efficiency
-        int temp = msg.buf[2];
-        temp = temp << 8;
-        temp |= msg.buf[3];
-        currLamb = temp;
-        currLamb *= 0.01; // base resolution from C125 dash manager
-        chngParamVal(7, currLamb);
-      }
+/**
+ * @brief Raises the "Slow Down" warning when oil pressure drops past the critical limit for the current RPM
+ *
+ * @param msg the memory address of the CAN message recieved (CAN ID 0x644), already decoded by decodeOilPressure()
+ */
+void checkOilPressureSlowDown(const CAN_message_t &msg)
+{
+  if (currRPM > 500)
+  {
+    // raise ECTO warning + "Slow Down" screen
+    if ((currOilPSR <= 20 && currRPM >= 3000) || (currOilPSR <= 40 && currRPM >= 6000) || (currOilPSR <= 45 && currRPM >= 7000))
+    {
+      // chngScrnSlowDown();                       // can't call "chngScrn()" directly for some reason
+      chngParamVal(18, WARN_OPRSR);
+    }
+    else
+    {
+      // returnToLastNormScrn();
+    }
+  }
+}
 
 /**
  * @deprecated maxWS statement below was bugged last time used on BM-22 at FSAE MIS
  */
 #warning maxWS statement below was bugged last time used on BM-22 at FSAE MIS
-      else if (msg.id == 1608) // CAN ID 0x648
-      {
-        int temp = 0;
-        temp = msg.buf[6];
-        temp = temp << 8;
-        temp |= msg.buf[7];
-        temp = temp * 0.1; // base resolution
-        temp *= 1.609344;  // conv from km/h to mph
-        if (temp > maxWSpd)
-        {
-          maxWSpd = temp;
-        }
-        chngParamVal(14, maxWSpd);
+/**
+ * @brief Decodes the all-drive wheelspeed from CAN ID 0x648 and tracks its maximum
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeWheelSpeed(const CAN_message_t &msg)
+{
+  int temp = M150_WheelSpeed::value(msg.buf);
+  if (temp > maxWSpd)
+  {
+    maxWSpd = temp;
+  }
+  chngParamVal(14, maxWSpd);
+}
 
-        temp /= currRPM;
-        // checkShiftRatio(temp);
-      }
-    }
+/**
+ * @brief Runs the gear estimator on the wheelspeed from CAN ID 0x648, on every screen since the M150 uses it
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeGearEstimate(const CAN_message_t &msg)
+{
+  estimateGear(M150_WheelSpeed::raw(msg.buf), currRPM, getTime());
+}
+
+/**
+ * @brief Decodes engine coolant and oil temperatures from CAN ID 0x649 and raises/clears the ECTO and OTEMP warnings
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeTemps(const CAN_message_t &msg)
+{
+  currECT = M150_ECT::value(msg.buf);
+  chngParamVal(2, currECT);
+
+  currOilTemp = M150_OilTemp::value(msg.buf);
+  chngParamVal(22, currOilTemp);
+
+  if (currECT >= 220) // raise ECTO warning
+  {
+    chngParamVal(18, 1);
   }
   else
   {
-    if (msg.id == 1613) // CAN ID 0x64D
+    if (WARN_ECTO == 1)
     {
-      // lock code from executing other statements, return to updating gear pos
-
-      int mask = 0x0F;
-      int mask2 = 0b00000111; // 0000 0111 ; the sign is extended from bit 3
-      currGearP = msg.buf[6];
-      currGearP &= mask;
-      currGearP &= mask2;
-      chngParamVal(6, currGearP);
+      chngParamVal(18, 0);
     }
-    else
+  }
+
+  if (currOilTemp >= 220) // raise OTEMP warning
+  {
+    chngParamVal(20, 1);
+  }
+  else
+  {
+    if (WARN_OTEMP == 1)
     {
-      return;
+      chngParamVal(20, 0);
     }
   }
 }
 
 /**
- * @brief Changes the screen of the LCD
+ * @brief Raises the "Slow Down" warning when coolant or oil temperature passes the critical limit
  *
- * @param page An enum that indicates the page to switch to, title accurate
+ * @param msg the memory address of the CAN message recieved (CAN ID 0x649), already decoded by decodeTemps()
  */
-void chngScrn(Screen page)
+void checkTempsSlowDown(const CAN_message_t &msg)
 {
-  switch (page)
+  if (currECT >= 240) // raise ECTO warning + "Slow Down" screen
   {
-  case Config1:
-    Serial1.print("page Config1");
-    endCommand();
-    currScreen = page;
-
-    chngParamVal(10, currRPM);
+    // chngScrnSlowDown();                       // can't call "chngScrn()" directly for some reason
+    chngParamVal(18, WARN_ECTO);
+  }
+  else
+  {
+    returnToLastNormScrn();
+  }
 
-    break;
+  if (currOilTemp >= 240) // raise OTEMP warning + "Slow Down" screen
+  {
+    // chngScrnSlowDown();                       // can't call "chngScrn()" directly for some reason
+    chngParamVal(18, WARN_OTEMP);
+  }
+  else
+  {
+    returnToLastNormScrn();
+  }
+}
 
-  case Config2:
-    Serial1.print("page Config2");
-    endCommand();
-    currScreen = page;
+/**
+ * @brief Decodes battery voltage from CAN ID 0x649
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeBattery(const CAN_message_t &msg)
+{
+  currBatt = M150_Battery::value(msg.buf);
+  chngParamVal(0, currBatt);
+}
 
-#warning functions for changing timers are still bugged
-    chngParamVal(15, (int)timer_R[0]);
-    chngParamVal(16, (int)timer_R[1]);
-    chngParamVal(17, (int)timer_R[2]);
-    chngParamVal(12, (int)currTimerDel);
-    chngParamVal(13, currTimerDelPic);
-    chngParamVal(10, currRPM);
+/**
+ * @brief Decodes gear position from CAN ID 0x64D
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void decodeGear(const CAN_message_t &msg)
+{
+  currGearP = M150_GearP::raw(msg.buf);
+  chngParamVal(6, currGearP);
+}
 
-    break;
+/**
+ * @brief Finds the dispatch slot of a CAN ID, IDs in the M150 window index canDispatch directly,
+ * everything else is linearly probed in canOutliers
+ *
+ * @param id the CAN ID to look up
+ * @param create claim an empty outlier slot if the ID isn't found
+ * @return CANDispatchSlot* the ID's slot, nullptr if the ID has no decoders (or no room is left when creating)
+ */
+CANDispatchSlot *findCANSlot(uint32_t id, bool create)
+{
+  uint32_t index = id - CAN_ID_BASE; // wraps around for IDs below the window, so one compare covers both ends
+  if (index < CAN_ID_COUNT)
+  {
+    return &canDispatch[index];
+  }
 
-  case DragMode:
-    Serial1.print("page DragMode");
-    endCommand();
-    currScreen = page;
+  uint32_t hash = (id ^ (id >> 4)) & (CAN_OUTLIER_SLOTS - 1);
+  for (uint8_t probe = 0; probe < CAN_OUTLIER_SLOTS; probe++)
+  {
+    CANOutlierSlot &outlier = canOutliers[(hash + probe) & (CAN_OUTLIER_SLOTS - 1)];
+    if (outlier.id == id)
+    {
+      return &outlier.slot;
+    }
+    if (outlier.id == CAN_OUTLIER_EMPTY)
+    {
+      if (!create)
+      {
+        return nullptr;
+      }
+      outlier.id = id;
+      return &outlier.slot;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Adds a decoder to a CAN ID's dispatch slot, decoders run in the order they are registered
+ *
+ * @param id the CAN ID the decoder handles
+ * @param decode the decoder function
+ * @param screenMask the screens the decoder runs on, built with SCREEN_MASK() or ALL_SCREENS
+ * @return true if the decoder was added, false if the slot (or outlier table) is full
+ */
+bool registerCANDecoder(uint32_t id, CANDecoderFn decode, uint8_t screenMask)
+{
+  CANDispatchSlot *slot = findCANSlot(id, true);
+  if (slot == nullptr || slot->decoderCount >= MAX_DECODERS_PER_ID)
+  {
+    return false;
+  }
+
+  slot->decoders[slot->decoderCount].decode = decode;
+  slot->decoders[slot->decoderCount].screenMask = screenMask;
+  slot->decoderCount++;
+  return true;
+}
+
+/**
+ * @brief Sets the decode priority and rate limit of a CAN ID, IDs default to PRIORITY_LOW with no rate limit
+ *
+ * @param id the CAN ID, must already have a decoder registered
+ * @param priority the decode order of the ID within a loop() pass
+ * @param minInterval minimum time between decodes of the ID (ms), newer frames coalesce in the meantime
+ * @return true if the ID was found
+ */
+bool setCANPriority(uint32_t id, CANPriority priority, uint16_t minInterval)
+{
+  CANDispatchSlot *slot = findCANSlot(id, false);
+  if (slot == nullptr || slot->decoderCount == 0)
+  {
+    return false;
+  }
+
+  canPriorityMask[slot->priority] &= ~(1UL << slot->pendingBit);
+  canPriorityMask[priority] |= 1UL << slot->pendingBit;
+  slot->priority = priority;
+  slot->minInterval = minInterval;
+  return true;
+}
+
+/**
+ * @brief Builds the CAN dispatch table, this is the only place that needs to change when a channel is added
+ *
+ */
+void initCANDispatch()
+{
+  for (uint8_t i = 0; i < CAN_ID_COUNT; i++)
+  {
+    canDispatch[i].pendingBit = i;
+    canDispatch[i].priority = PRIORITY_LOW;
+  }
+  for (uint8_t i = 0; i < CAN_OUTLIER_SLOTS; i++)
+  {
+    canOutliers[i].id = CAN_OUTLIER_EMPTY;
+    canOutliers[i].slot.pendingBit = CAN_ID_COUNT + i;
+    canOutliers[i].slot.priority = PRIORITY_LOW;
+  }
+  canPriorityMask[PRIORITY_LOW] = (1UL << CAN_PENDING_BITS) - 1;
+
+  // every decoder runs on every screen, so values stay current for replayScreen() and maxWSpd keeps its peak,
+  // screenParams alone decides what goes out to the LCD
+  registerCANDecoder(M150_ID_ENGINE, decodeRPM, ALL_SCREENS);                           // CAN ID 0x640
+  registerCANDecoder(M150_ID_ENGINE, decodeMAP, ALL_SCREENS);                           // CAN ID 0x640
+  registerCANDecoder(M150_ID_FUEL, decodeFuelPressure, ALL_SCREENS);                    // CAN ID 0x641
+  registerCANDecoder(M150_ID_FUEL, checkFuelPressureSlowDown, ALL_SCREENS);             // CAN ID 0x641
+  registerCANDecoder(M150_ID_FUEL, decodeLambda, ALL_SCREENS);                          // CAN ID 0x641
+  registerCANDecoder(M150_ID_THROTTLE, decodeThrottle, ALL_SCREENS);                    // CAN ID 0x642
+  registerCANDecoder(M150_ID_OIL_PRESSURE, decodeOilPressure, ALL_SCREENS);             // CAN ID 0x644
+  registerCANDecoder(M150_ID_OIL_PRESSURE, checkOilPressureSlowDown, ALL_SCREENS);      // CAN ID 0x644
+  registerCANDecoder(M150_ID_WHEELSPEED, decodeWheelSpeed, ALL_SCREENS);                // CAN ID 0x648
+  registerCANDecoder(M150_ID_WHEELSPEED, decodeGearEstimate, ALL_SCREENS);              // CAN ID 0x648
+  registerCANDecoder(M150_ID_TEMPS, decodeTemps, ALL_SCREENS);                          // CAN ID 0x649
+  registerCANDecoder(M150_ID_TEMPS, decodeBattery, ALL_SCREENS);                        // CAN ID 0x649
+  registerCANDecoder(M150_ID_TEMPS, checkTempsSlowDown, ALL_SCREENS);                   // CAN ID 0x649
+  registerCANDecoder(M150_ID_GEAR, decodeGear, ALL_SCREENS);                            // CAN ID 0x64D
+
+  setCANPriority(M150_ID_GEAR, PRIORITY_CRITICAL, 0);                                   // one-shot, never rate limited
+  setCANPriority(M150_ID_ENGINE, PRIORITY_CRITICAL, 0);                                 // drives the shift lights
+  setCANPriority(M150_ID_OIL_PRESSURE, PRIORITY_HIGH, 50);
+  setCANPriority(M150_ID_FUEL, PRIORITY_HIGH, 50);
+  setCANPriority(M150_ID_TEMPS, PRIORITY_LOW, 100);
+  setCANPriority(M150_ID_THROTTLE, PRIORITY_LOW, 50);
+  setCANPriority(M150_ID_WHEELSPEED, PRIORITY_LOW, 50);
+}
+
+/**
+ * @brief FlexCAN FIFO interrupt handler, deposits the frame into its ID's latest-value slot for loop() to decode
+ * Copied from the FlexCANT4 CAN2.0_example_FIFO_with_interrupts.ino example
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void CANmsgRecieve(const CAN_message_t &msg)
+{
+  // canSniff(msg);
+
+  canFilterStats.recieved++;
+
+  CANDispatchSlot *slot = findCANSlot(msg.id, false);
+  if (slot == nullptr || slot->decoderCount == 0)
+  {
+    canFilterStats.rejected++;
+    return;
+  }
+
+  slot->latest = msg;
+  slot->seq++;
+  canPendingMask |= 1UL << slot->pendingBit;
+}
+
+/**
+ * @brief Mailbox interrupt handler for RPM, only adds the reading to the RPM history, stamped when it arrived.
+ * FlexCAN_T4 runs the global handler, CANmsgRecieve(), right after this one, which deposits the frame for loop(),
+ * where decodeRPM() runs the slope fit and the shift lights
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void rpmFastPathRecieve(const CAN_message_t &msg)
+{
+  recordRPM(M150_RPM::raw(msg.buf), currGearP);
+}
+
+/**
+ * @brief Mailbox interrupt handler for gear position, keeps currGearP current for the shift lights' thresholds,
+ * CANmsgRecieve() then deposits the frame as for any other ID
+ *
+ * @param msg the memory address of the CAN message recieved
+ */
+void gearFastPathRecieve(const CAN_message_t &msg)
+{
+  currGearP = M150_GearP::raw(msg.buf);
+}
+
+/**
+ * @brief Sets up the dedicated RX mailboxes for RPM and gear position, must be called after enableFIFO() and
+ * initCANDispatch(), and before setupCANFilters() so these IDs are left out of the FIFO's filter table
+ *
+ */
+void setupCANFastPath()
+{
+#if CAN_FAST_PATH
+  Can0.setMRP(true); // mailboxes are matched before the FIFO
+
+  Can0.setMB(CAN_FAST_PATH_MB_RPM, RX, STD);
+  Can0.setMBFilter(CAN_FAST_PATH_MB_RPM, M150_ID_ENGINE);
+  Can0.onReceive(CAN_FAST_PATH_MB_RPM, rpmFastPathRecieve);
+  Can0.enableMBInterrupt(CAN_FAST_PATH_MB_RPM);
+  findCANSlot(M150_ID_ENGINE, false)->fastPath = true;
+
+  Can0.setMB(CAN_FAST_PATH_MB_GEAR, RX, STD);
+  Can0.setMBFilter(CAN_FAST_PATH_MB_GEAR, M150_ID_GEAR);
+  Can0.onReceive(CAN_FAST_PATH_MB_GEAR, gearFastPathRecieve);
+  Can0.enableMBInterrupt(CAN_FAST_PATH_MB_GEAR);
+  findCANSlot(M150_ID_GEAR, false)->fastPath = true;
+#endif
+}
+
+/**
+ * @brief Maps a canPendingMask bit back to its dispatch slot
+ *
+ * @param bit the slot's pendingBit
+ * @return CANDispatchSlot* the slot, dense slots first then outliers
+ */
+CANDispatchSlot *slotFromPendingBit(uint8_t bit)
+{
+  return (bit < CAN_ID_COUNT) ? &canDispatch[bit] : &canOutliers[bit - CAN_ID_COUNT].slot;
+}
+
+/**
+ * @brief Maps a canPendingMask bit back to the CAN ID its slot handles
+ *
+ * @param bit the slot's pendingBit
+ * @return uint32_t the CAN ID, CAN_OUTLIER_EMPTY for an unused outlier slot
+ */
+uint32_t idFromPendingBit(uint8_t bit)
+{
+  return (bit < CAN_ID_COUNT) ? CAN_ID_BASE + bit : canOutliers[bit - CAN_ID_COUNT].id;
+}
+
+/**
+ * @brief Finds how many of the sorted IDs from ids[i] on one range filter can take without waking for anything else
+ *
+ * A range filter is a base ID and a mask, so it accepts every ID the mask lets through (0x641-0x642 would also
+ * wake for 0x640 and 0x643). Only a power-of-two block starting on a multiple of its size is exact, so a run of
+ * consecutive IDs is cut into the largest such block at its start.
+ *
+ * @return uint8_t index of the block's last ID, i when the ID has to go in a filter on its own
+ */
+uint8_t canFilterBlockEnd(const uint32_t *ids, uint8_t i, uint8_t idCount)
+{
+  uint8_t runEnd = i;
+  while (runEnd + 1 < idCount && ids[runEnd + 1] == ids[runEnd] + 1)
+  {
+    runEnd++;
+  }
+
+  uint32_t size = 1;
+  while ((ids[i] & (size * 2 - 1)) == 0 && i + size * 2 - 1 <= runEnd)
+  {
+    size *= 2;
+  }
+  return i + size - 1;
+}
+
+/**
+ * @brief Programs the FlexCAN acceptance filters so only IDs with a registered decoder ever reach the ISR
+ *
+ * Aligned blocks of consecutive IDs share one range filter. A two-ID filter is an ID/mask compare as well, so two lone
+ * IDs only share one when they differ in a single bit, otherwise each gets an exact entry of its own. Fast path IDs
+ * are skipped since they have their own mailboxes. Once the FIFO's filter table is full the rest of the IDs go to
+ * filtered RX mailboxes (CAN_FIRST_FILTER_MB onwards), which use the same onReceive handler.
+ * If even the mailboxes run out, filtering is turned off so no channel is lost, the dispatcher still ignores
+ * the extra frames in software. Must be called after enableFIFO() and after initCANDispatch().
+ *
+ * @return uint8_t the number of FIFO filter table entries used
+ */
+uint8_t setupCANFilters()
+{
+#ifdef CAN_ACCEPT_ALL // build with -D CAN_ACCEPT_ALL to compare canFilterStats against an unfiltered bus
+  Can0.setFIFOFilter(ACCEPT_ALL);
+  return 0;
+#endif
+
+  uint32_t ids[CAN_PENDING_BITS];
+  uint8_t idCount = 0;
+  for (uint8_t bit = 0; bit < CAN_PENDING_BITS; bit++)
+  {
+    const CANDispatchSlot *slot = slotFromPendingBit(bit);
+    if (slot->decoderCount != 0 && !slot->fastPath)
+    {
+      ids[idCount++] = idFromPendingBit(bit);
+    }
+  }
+
+  /* insertion sort, the dense window is already in order so only outliers ever move */
+  for (uint8_t i = 1; i < idCount; i++)
+  {
+    uint32_t id = ids[i];
+    uint8_t j = i;
+    for (; j > 0 && ids[j - 1] > id; j--)
+    {
+      ids[j] = ids[j - 1];
+    }
+    ids[j] = id;
+  }
 
-    chngParamVal(12, (int)currTimerDel);
-    chngParamVal(14, maxWSpd);
-    chngParamVal(10, currRPM);
+  Can0.setRFFN(RFFN_8);
+  Can0.setFIFOFilter(REJECT_ALL);
 
+  uint8_t filter = 0;
+  uint8_t mb = CAN_FIRST_FILTER_MB;
+  uint8_t i = 0;
+  while (i < idCount)
+  {
+    uint8_t runEnd = canFilterBlockEnd(ids, i, idCount);
+    bool nextIsSingle = (runEnd + 1 < idCount) && canFilterBlockEnd(ids, runEnd + 1, idCount) == runEnd + 1;
+    uint32_t pairBits = nextIsSingle ? ids[i] ^ ids[i + 1] : 0;
+    bool pairExact = pairBits != 0 && (pairBits & (pairBits - 1)) == 0; // the mask leaves out one bit, no extras
+
+    if (filter < CAN_FIFO_FILTERS)
+    {
+      if (runEnd > i)
+      {
+        Can0.setFIFOFilterRange(filter++, ids[i], ids[runEnd], STD);
+      }
+      else if (pairExact)
+      {
+        Can0.setFIFOFilter(filter++, ids[i], ids[i + 1], STD);
+        runEnd++;
+      }
+      else
+      {
+        Can0.setFIFOFilter(filter++, ids[i], STD);
+      }
+    }
+    else if (mb <= CAN_LAST_FILTER_MB)
+    {
+      Can0.setMB((FLEXCAN_MAILBOX)mb, RX, STD);
+      if (runEnd > i)
+      {
+        Can0.setMBFilterRange((FLEXCAN_MAILBOX)mb, ids[i], ids[runEnd]);
+      }
+      else
+      {
+        Can0.setMBFilter((FLEXCAN_MAILBOX)mb, ids[i]);
+      }
+      Can0.enableMBInterrupt((FLEXCAN_MAILBOX)mb);
+      mb++;
+    }
+    else
+    {
+      Can0.setFIFOFilter(ACCEPT_ALL);
+      return CAN_FIFO_FILTERS;
+    }
+
+    i = runEnd + 1;
+  }
+
+  return filter;
+}
+
+/**
+ * @brief Frames that reached the ISR but have no decoder, with the hardware filters doing their job this stays
+ * at 0 (it can't see the frames FlexCAN_T4 drops itself, which never get this far)
+ *
+ * @return uint32_t rejected frame count since boot
+ */
+uint32_t getCANRejectedFrames()
+{
+  return canFilterStats.rejected;
+}
+
+/**
+ * @brief Frames per second that made it through the filters into the ISR since the last call, what the filters
+ * are saving shows up against the same bus with a -D CAN_ACCEPT_ALL build
+ *
+ * @return uint32_t ISR frames per second, 0 on the first call
+ */
+uint32_t getCANInterruptRate()
+{
+  uint32_t now = millis();
+  uint32_t frames = canFilterStats.recieved;
+  uint32_t elapsed = now - canFilterStats.rateSince;
+  uint32_t rate = (elapsed != 0 && canFilterStats.rateSince != 0) ? (uint32_t)((uint64_t)(frames - canFilterStats.rateFrames) * 1000 / elapsed) : 0;
+  canFilterStats.rateSince = now;
+  canFilterStats.rateFrames = frames;
+  return rate;
+}
+
+/**
+ * @brief Runs the decoders of a slot that are subscribed to the current screen
+ *
+ * @param slot the dispatch slot of the frame's ID
+ * @param msg a copy of the latest frame for that ID
+ * @return true if at least one decoder ran
+ */
+bool dispatchCANFrame(const CANDispatchSlot &slot, const CAN_message_t &msg)
+{
+  bool decoded = false;
+  const uint8_t screenBit = SCREEN_MASK(currScreen);
+  for (uint8_t i = 0; i < slot.decoderCount; i++)
+  {
+    if (slot.decoders[i].screenMask & screenBit)
+    {
+      slot.decoders[i].decode(msg);
+      decoded = true;
+    }
+  }
+  return decoded;
+}
+
+/**
+ * @brief Decodes every slot the ISR has deposited a frame into since the last call, highest CANPriority first,
+ * only the newest frame of each ID is decoded, older ones were overwritten (coalesced) in the slot
+ *
+ * Slots still inside their minInterval are put back into canPendingMask and picked up on a later pass. Frames
+ * overwritten while a slot waits like that are what the rate limit cost (stats.dropped), the ones overwritten before
+ * any pass saw the slot are what a late loop() cost (stats.coalesced).
+ */
+void processCANFrames()
+{
+  noInterrupts();
+  uint32_t pending = canPendingMask;
+  canPendingMask = 0;
+  interrupts();
+
+  uint32_t deferred = 0;
+  long unsigned int now = getTime();
+
+  for (uint8_t priority = 0; priority < PRIORITY_COUNT; priority++)
+  {
+    uint32_t bits = pending & canPriorityMask[priority];
+    while (bits != 0)
+    {
+      uint8_t bit = __builtin_ctz(bits);
+      bits &= bits - 1;
+
+      CANDispatchSlot *slot = slotFromPendingBit(bit);
+      if (slot->minInterval != 0 && now - slot->lastDecodeTime < slot->minInterval)
+      {
+        if (!slot->held)
+        {
+          slot->held = true;
+          slot->heldSeq = slot->seq;
+        }
+        deferred |= 1UL << bit;
+        continue;
+      }
+
+      noInterrupts(); // the ISR could be rewriting latest mid-copy otherwise
+      CAN_message_t msg = slot->latest;
+      uint32_t seq = slot->seq;
+      interrupts();
+
+      uint32_t frames = seq - slot->processedSeq;
+      uint32_t thinned = slot->held ? seq - slot->heldSeq : 0;
+      slot->processedSeq = seq;
+      slot->held = false;
+      slot->lastDecodeTime = now;
+
+      if (dispatchCANFrame(*slot, msg))
+      {
+        slot->stats.processed++;
+      }
+      slot->stats.coalesced += frames - 1 - thinned;
+      slot->stats.dropped += thinned;
+    }
+  }
+
+  if (deferred != 0)
+  {
+    noInterrupts();
+    canPendingMask |= deferred;
+    interrupts();
+  }
+}
+
+/**
+ * @brief Prints the processed/coalesced/dropped frame counters of every CAN ID to the USB serial monitor
+ *
+ */
+void printCANStats()
+{
+  for (uint8_t bit = 0; bit < CAN_PENDING_BITS; bit++)
+  {
+    const CANDispatchSlot *slot = slotFromPendingBit(bit);
+    if (slot->decoderCount == 0)
+    {
+      continue;
+    }
+
+    Serial.print("ID   ");
+    Serial.print(idFromPendingBit(bit), HEX);
+    Serial.print("   PRIORITY:   ");
+    Serial.print(slot->priority);
+    Serial.print("   PROCESSED:   ");
+    Serial.print(slot->stats.processed);
+    Serial.print("   COALESCED:   ");
+    Serial.print(slot->stats.coalesced);
+    Serial.print("   DROPPED:   ");
+    Serial.println(slot->stats.dropped);
+  }
+
+  Serial.print("ISR FRAMES:   ");
+  Serial.print(canFilterStats.recieved);
+  Serial.print("   PER SECOND:   ");
+  Serial.print(getCANInterruptRate());
+  Serial.print("   REJECTED:   ");
+  Serial.println(getCANRejectedFrames());
+}
+
+/**
+ * @brief Changes the screen of the LCD
+ *
+ * @param page An enum that indicates the page to switch to, title accurate
+ */
+void chngScrn(Screen page)
+{
+  invalidateParamCache(); // the Nextion resets every component to its HMI default on a page change
+  paramPendingMask = 0;   // anything still queued belongs to the old page
+  nextionTxClear();
+
+  switch (page)
+  {
+  case Config1:
+    nextionSendRaw("page Config1");
+    currScreen = page;
+    currBSPD = Standby;
     break;
 
-  case Params:
-    Serial1.print("page Params");
-    endCommand();
+  case Config2:
+    nextionSendRaw("page Config2");
     currScreen = page;
+    currBSPD = Standby;
+#warning functions for changing timers are still bugged
+    break;
 
-    chngParamVal(14, maxWSpd);
+  case DragMode:
+    nextionSendRaw("page DragMode");
+    currScreen = page;
+    currBSPD = Standby;
+    break;
 
+  case Params:
+    nextionSendRaw("page Params");
+    currScreen = page;
+    currBSPD = Standby;
     break;
 
   case BSPD_Trig:
-    Serial1.print("page BSPD_Trig");
-    endCommand();
+    nextionSendRaw("page BSPD_Trig");
     irregScreen = true;
+    currBSPD = Trig;
     break;
 
   case BSPD_Trip:
-    Serial1.print("page BSPD_Trip");
-    endCommand();
+    nextionSendRaw("page BSPD_Trip");
     irregScreen = true;
+    currBSPD = TRIP;
     break;
 
   case Shift:
-    Serial1.print("page Shift");
-    endCommand();
+    nextionSendRaw("page Shift");
     irregScreen = true;
     break;
 
   case SlowDown:
-    Serial1.print("page SlowDown");
-    endCommand();
+    nextionSendRaw("page SlowDown");
     irregScreen = true;
     break;
 
   default:
-    Serial1.print("page Config1");
-    endCommand();
+    nextionSendRaw("page Config1");
     currScreen = Config1;
+    page = Config1;
     break;
   }
 
@@ -520,325 +995,1036 @@ void chngScrn(Screen page)
   chngParamVal(19, WARN_FPRSR);
   chngParamVal(20, WARN_OTEMP);
   chngParamVal(21, WARN_OPRSR);
+
+  replayScreen(page);
+}
+
+/**
+ * @brief Re-sends every known value the new page shows in one burst right after the page command, so the page
+ * comes up complete instead of filling in as each channel's next CAN frame arrives
+ *
+ * @details The burst is wrapped in ref_stop/ref_star so the LCD paints the page once, and goes out in
+ * lcdFramePriority order. It isn't held to the frame budget, one burst per page change is worth it.
+ *
+ * @param page the page that was just switched to
+ */
+void replayScreen(Screen page)
+{
+  uint32_t replay = screenParams[page] & paramKnownMask;
+  uint16_t budget = 0xFFFF;
+
+  nextionSendRaw("ref_stop");
+  for (uint8_t i = 0; i < PARAM_COUNT; i++)
+  {
+    uint8_t paramCode = lcdFramePriority[i];
+    if ((replay & PARAM_BIT(paramCode)) == 0)
+    {
+      continue;
+    }
+
+    char cmd[NEXTION_CMD_MAX];
+    uint8_t len = formatParam(cmd, paramCode);
+    if (writeParam(paramCode, paramPending[paramCode].val, cmd, len, budget))
+    {
+      paramPendingMask &= ~PARAM_BIT(paramCode);
+    }
+  }
+  nextionSendRaw("ref_star");
 }
 
 /**
- * @brief Changes all FLOATING POINT parameters on the LCD
+ * @brief Changes all parameters on the LCD, values are integers from the CAN decoders all the way to the
+ * display, paramCodes 0, 7 and 11 are fixed-point in hundredths (see the CANSignal Decimals parameter)
  *
- * @param paramCode an integer that defines what parameter is being changed
- * @param val the specified parameter's new floating point value
+ * @details The curr* value is always updated, whether or not the current screen shows the parameter, that's
+ * decided by screenParams in queueParam()
+ *
+ * @param paramCode an integer that determines what parameter is being changed
+ * @param val the specified parameter's new integer value INCLUDING WARNINGS
  */
-void chngParamVal(int paramCode, double val)
+void chngParamVal(int paramCode, int val)
 {
   switch (paramCode)
   {
   case 0:
     currBatt = val;
-    Serial1.print("Batt.txt=\"" + String(currBatt) + "\"");
-    endCommand();
+    queueParamFixedTxt(0, currBatt, 2);
     break;
 
-  case 7:
-    currLamb = val;
-    Serial1.print("Lam.txt=\"" + String(currLamb) + "\"");
-    endCommand();
+  case 2:
+    currECT = val;
+    queueParamInt(2, currECT);
+    break;
+
+  case 3:
+    currFrontBP = val;
+    queueParamInt(3, currFrontBP);
+    break;
+
+  case 4:
+    currRearBP = val;
+    queueParamInt(4, currRearBP);
+    break;
+
+  case 5:
+    currFuelPSR = val;
+    queueParamInt(5, currFuelPSR);
+    break;
+
+  case 6:
+    currGearP = (int)val;
+    queueParamInt(6, currGearP);
+    break;
+
+  case 7:
+    currLamb = val;
+    queueParamFixedTxt(7, currLamb, 2);
+    break;
+
+  case 8:
+    currMAP = val;
+    queueParamInt(8, currMAP);
+    break;
+
+  case 9:
+    currOilPSR = val;
+    queueParamInt(9, currOilPSR);
+    break;
+
+  case 10:
+    currRPM = val;
+    queueParamInt(10, currRPM);
     break;
 
   case 11:
     currThrtl = val;
-    Serial1.print("Thrt.txt=\"" + String(currThrtl) + "\"");
-    endCommand();
+    queueParamFixedTxt(11, currThrtl, 2);
     break;
 
   case 12:
     currTimerDel = val;
-    Serial1.print("timer_Delta.txt=\"" + convMSec_to_TForm(val) + "\"");
-    endCommand();
+    queueParamTimeTxt(12, val);
+    break;
+
+  case 13:
+    currTimerDelPic = val;
+    queueParamInt(13, (currTimerDelPic == 0) ? 6 : 7);
+    break;
+
+  case 14:
+    maxWSpd = val;
+    queueParamInt(14, maxWSpd);
     break;
 
   case 15:
     timer_R[0] = val;
-    Serial1.print("timer_R1.txt=\"" + convMSec_to_TForm(val) + "\"");
-    endCommand();
+    queueParamTimeTxt(15, val);
     break;
 
   case 16:
     timer_R[1] = val;
-    Serial1.print("timer_R2.txt=\"" + convMSec_to_TForm(val) + "\"");
-    endCommand();
+    queueParamTimeTxt(16, val);
+    break;
+
+  case 17:
+    timer_R[2] = val;
+    queueParamTimeTxt(17, val);
     break;
 
-  case 17:
-    timer_R[2] = val;
-    Serial1.print("timer_R3.txt=\"" + convMSec_to_TForm(val) + "\"");
-    endCommand();
-    break;
+  case 18:
+    WARN_ECTO = val;
+    if (WARN_ECTO == 1)
+    {
+      queueParamInt(18, 1);
+    }
+    else
+    {
+      queueParamInt(18, 4);
+    }
+    break;
+
+  case 19:
+    WARN_FPRSR = val;
+    if (WARN_FPRSR == 1)
+    {
+      queueParamInt(19, 2);
+    }
+    else
+    {
+      queueParamInt(19, 4);
+    }
+    break;
+
+  case 20:
+    WARN_OTEMP = val;
+    if (WARN_OTEMP == 1)
+    {
+      queueParamInt(20, 3);
+    }
+    else
+    {
+      queueParamInt(20, 4);
+    }
+    break;
+
+  case 21:
+    WARN_OPRSR = val;
+    if (WARN_OPRSR == 1)
+    {
+      queueParamInt(21, 10);
+    }
+    else
+    {
+      queueParamInt(21, 4);
+    }
+    break;
+
+  case 22:
+    currOilTemp = val;
+    queueParamInt(22, currOilTemp);
+    break;
+  }
+
+#ifdef LCD_TRACE
+  traceSample(paramCode, val);
+#endif
+
+#ifdef LCD_PACKED_FLAGS
+  if ((DASH_FLAG_SOURCES & PARAM_BIT(paramCode)) != 0)
+  {
+    queueParamInt(PARAM_DASH_FLAGS, packDashFlags()); // unchanged flags are suppressed by the value cache
+  }
+#endif
+}
+
+/**
+ * @brief Packs every on/off bit of display state into the dashFlags value, see DASH_FLAG_* in NextionLCD.h
+ *
+ * @return uint8_t the packed flags
+ */
+uint8_t packDashFlags()
+{
+  uint8_t flags = 0;
+  flags |= (WARN_ECTO == 1) ? DASH_FLAG_WARN_ECTO : 0;
+  flags |= (WARN_FPRSR == 1) ? DASH_FLAG_WARN_FPRSR : 0;
+  flags |= (WARN_OTEMP == 1) ? DASH_FLAG_WARN_OTEMP : 0;
+  flags |= (WARN_OPRSR == 1) ? DASH_FLAG_WARN_OPRSR : 0;
+  flags |= shiftLightOn ? DASH_FLAG_SHIFT : 0;
+  flags |= (currTimerDelPic != 0) ? DASH_FLAG_TIMER_POS : 0;
+  flags |= (currBSPD & 0x3) << DASH_FLAG_BSPD_SHIFT;
+  return flags;
+}
+
+/**
+ * @brief Forgets every value sent to the LCD, so the next update of each paramCode is written unconditionally
+ *
+ */
+void invalidateParamCache()
+{
+  for (uint8_t i = 0; i < PARAM_COUNT; i++)
+  {
+    paramCache[i].valid = false;
+  }
+}
+
+/**
+ * @brief Checks a paramCode's new command against what was last sent for it
+ *
+ * @param paramCode the parameter the command updates
+ * @param val the parameter's value
+ * @param cmd the new command
+ * @param len length of the command
+ * @return true if it's byte for byte the last command sent, or the value has moved but not past its deadband
+ * (plus hysteresis if it reversed direction) and not to 0
+ */
+bool paramSuppressed(int paramCode, int32_t val, const char *cmd, uint8_t len)
+{
+  const ParamCache &cache = paramCache[paramCode];
+  const ParamDeadband &band = paramDeadband[paramCode];
+  if (!cache.valid)
+  {
+    return false;
+  }
+  if (len == cache.renderedLen && memcmp(cmd, cache.rendered, len) == 0)
+  {
+    return true;
+  }
+  if (val == cache.lastVal)
+  {
+    return false; // same value rendered differently, the screen would change
+  }
+  if (val == 0)
+  {
+    return false; // engine stopped, pedal released, ... always shown
+  }
+
+  int32_t delta = val - cache.lastVal;
+  uint32_t mag = (delta < 0) ? -(uint32_t)delta : (uint32_t)delta;
+  int8_t dir = (delta > 0) - (delta < 0);
+
+  uint32_t threshold = band.deadband;
+  if (cache.lastDir != 0 && dir != cache.lastDir)
+  {
+    threshold = max(band.deadband, (uint16_t)1) + band.hysteresis;
+  }
+  return mag < threshold;
+}
+
+/**
+ * @brief Sends a formatted paramCode command to the LCD, unless it renders the same as the last command sent
+ * for that component or the value hasn't moved past its deadband (plus hysteresis if it reversed direction)
+ *
+ * @param paramCode the parameter the command updates
+ * @param val the parameter's value, used for the deadband/hysteresis checks
+ * @param cmd the formatted command, including its terminator
+ * @param len length of the command
+ * @param budget bytes left in the current LCD frame, reduced by len if the command is written
+ * @return true if the command was written or suppressed, false if it didn't fit into the budget
+ */
+bool writeParam(int paramCode, int32_t val, const char *cmd, uint8_t len, uint16_t &budget)
+{
+  ParamCache &cache = paramCache[paramCode];
+
+  if (paramSuppressed(paramCode, val, cmd, len))
+  {
+    lcdStats.cmdsSaved++;
+    lcdStats.bytesSaved += len;
+    return true;
+  }
+
+  if (len > budget || nextionTxFull(paramCode))
+  {
+    return false;
+  }
+  budget -= len;
+
+  int32_t delta = cache.valid ? val - cache.lastVal : 0;
+  cache.valid = true;
+  cache.lastVal = val;
+  cache.lastDir = (delta > 0) - (delta < 0);
+  cache.renderedLen = (len <= PARAM_CMD_MAX) ? len : 0;
+  memcpy(cache.rendered, cmd, cache.renderedLen);
+
+  lcdStats.cmdsSent++;
+  lcdStats.bytesSent += len;
+  nextionWrite(cmd, len, paramCode);
+
+  if (bootTiming.firstLiveValue == BOOT_NOT_YET && bootTiming.firstRPM != BOOT_NOT_YET)
+  {
+    bootTiming.firstLiveValue = getTime();
+    bootTiming.firstLiveParam = paramCode;
+  }
+  return true;
+}
+
+/**
+ * @brief Stores a paramCode's latest value and, if the current screen shows it, queues it for the next LCD
+ * frame, overwriting any value still waiting
+ *
+ */
+void queueParam(int paramCode, int32_t val, ParamFormat format, uint8_t decimals)
+{
+  paramPending[paramCode].val = val;
+  paramPending[paramCode].format = format;
+  paramPending[paramCode].decimals = decimals;
+  paramKnownMask |= PARAM_BIT(paramCode);
+
+  if ((screenParams[currScreen] & PARAM_BIT(paramCode)) == 0)
+  {
+    return; // not on this screen, writing components that aren't on screen cause errors & lag w/ screen
+  }
+  paramPendingMask |= (1UL << paramCode);
+}
+
+/**
+ * @brief Queues a paramCode's numeric (.val= / .pic=) command
+ *
+ */
+void queueParamInt(int paramCode, int32_t val)
+{
+  queueParam(paramCode, val, PARAM_INT, 0);
+}
+
+/**
+ * @brief Queues a paramCode's fixed-point text command
+ *
+ */
+void queueParamFixedTxt(int paramCode, int32_t val, uint8_t decimals)
+{
+  queueParam(paramCode, val, PARAM_FIXED_TXT, decimals);
+}
+
+/**
+ * @brief Queues a paramCode's "m:ss" text command
+ *
+ */
+void queueParamTimeTxt(int paramCode, uint32_t msec)
+{
+  queueParam(paramCode, msec, PARAM_TIME_TXT, 0);
+}
+
+/**
+ * @brief Adds a chngParamVal() value to the current pixel of the trace channel it feeds, if any
+ *
+ */
+void traceSample(int paramCode, int val)
+{
+  for (uint8_t ch = 0; ch < TRACE_CHANNELS; ch++)
+  {
+    if (traceChannels[ch].paramCode == paramCode)
+    {
+      traceChannels[ch].sum += val;
+      traceChannels[ch].count++;
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Closes the current trace pixel every 1/TRACE_PIXEL_HZ seconds, averaging each channel's values into
+ * one waveform point
+ *
+ */
+void traceTick()
+{
+  static long unsigned int lastPixelTime;
+  if (getTime() - lastPixelTime < 1000 / TRACE_PIXEL_HZ)
+  {
+    return;
+  }
+  lastPixelTime = getTime();
+
+  for (uint8_t ch = 0; ch < TRACE_CHANNELS; ch++)
+  {
+    TraceChannel &trace = traceChannels[ch];
+    if (trace.count != 0)
+    {
+      int32_t avg = constrain(trace.sum / trace.count, trace.min, trace.max);
+      trace.last = (avg - trace.min) * TRACE_HEIGHT / (trace.max - trace.min);
+      trace.sum = 0;
+      trace.count = 0;
+    }
+    trace.ring[traceHead % TRACE_RING_SIZE] = trace.last;
+  }
+  traceHead++;
+
+  if (traceHead - traceTail > TRACE_RING_SIZE)
+  {
+    traceOverwritten += traceHead - traceTail - TRACE_RING_SIZE;
+    traceTail = traceHead - TRACE_RING_SIZE;
+  }
+}
+
+/**
+ * @brief Sends the next TRACE_BATCH points of every channel, one addt each, once they're in the ring and the
+ * trace's byte budget allows it
+ *
+ */
+void traceFlush()
+{
+  static long unsigned int lastFlushTime;
+  static uint32_t credit; // bytes the trace may send, earned at TRACE_BYTES_PER_S
+  const uint32_t cost = TRACE_CHANNELS * (TRACE_ADDT_OVERHEAD + TRACE_BATCH);
+
+  long unsigned int now = getTime();
+  credit = min(credit + (now - lastFlushTime) * TRACE_BYTES_PER_S / 1000, 2 * cost);
+  lastFlushTime = now;
+
+  if (currScreen != TRACE_SCREEN || irregScreen || traceHead - traceTail < TRACE_BATCH || credit < cost ||
+      nextionTxFree() <= TRACE_CHANNELS)
+  {
+    return;
+  }
+  credit -= cost;
+
+  for (uint8_t ch = 0; ch < TRACE_CHANNELS; ch++)
+  {
+    uint8_t points[TRACE_BATCH];
+    for (uint8_t i = 0; i < TRACE_BATCH; i++)
+    {
+      points[i] = traceChannels[ch].ring[(traceTail + i) % TRACE_RING_SIZE];
+    }
+    nextionSendAddt(TRACE_WAVEFORM_ID, ch, points, TRACE_BATCH);
+  }
+  traceTail += TRACE_BATCH;
+}
+
+/**
+ * @brief Formats a paramCode's stored value into its LCD command
+ *
+ * @param cmd output buffer, at least NEXTION_CMD_MAX bytes
+ * @param paramCode the parameter to format
+ * @return uint8_t length of the command including the terminator
+ */
+uint8_t formatParam(char *cmd, uint8_t paramCode)
+{
+  const ParamPending &pending = paramPending[paramCode];
+  switch (pending.format)
+  {
+  case PARAM_FIXED_TXT:
+    return nextionFormatFixedTxt(cmd, paramPrefix[paramCode], pending.val, pending.decimals);
+
+  case PARAM_TIME_TXT:
+    return nextionFormatTimeTxt(cmd, paramPrefix[paramCode], pending.val);
+
+  default:
+    return nextionFormatInt(cmd, paramPrefix[paramCode], pending.val);
+  }
+}
+
+/**
+ * @brief Writes one LCD frame every 1/LCD_FRAME_HZ seconds, no matter how fast CAN frames come in
+ *
+ * @details Queued paramCodes go out in lcdFramePriority order until the frame's byte budget (the link's
+ * bytes/s at lcdBaud split over LCD_FRAME_HZ frames) is used up. Anything that doesn't fit stays queued
+ * for the next frame, so the LCD's UART can never fall behind by more than one frame.
+ *
+ * On LCD_BATCH_SCREENS, with lcdBaud at LCD_BATCH_MIN_BAUD or more, the frame is wrapped in ref_stop/ref_star,
+ * so the LCD repaints once per frame instead of once per component, and RPM and gear can't tear against each other.
+ *
+ */
+void composeLCDFrame()
+{
+  static long unsigned int lastFrameTime;
+
+  if (paramPendingMask == 0 || getTime() - lastFrameTime < 1000 / LCD_FRAME_HZ)
+  {
+    return;
+  }
+  lastFrameTime = getTime();
+
+  adaptLCDRate();
+  long unsigned int linkBytes = lcdBaud / 10;
+#ifdef LCD_TRACE
+  if (currScreen == TRACE_SCREEN)
+  {
+    linkBytes -= min(linkBytes / 2, (long unsigned int)TRACE_BYTES_PER_S); // left for traceFlush()
+  }
+#endif
+  uint16_t budget = max(linkBytes / LCD_FRAME_HZ * lcdRatePercent / 100, (long unsigned int)NEXTION_CMD_MAX);
+  bool batch = (LCD_BATCH_SCREENS & (1 << currScreen)) != 0 && lcdBaud >= LCD_BATCH_MIN_BAUD;
+  bool frameOpen = false; // ref_stop sent, ref_star owed
+
+  for (uint8_t i = 0; i < PARAM_COUNT && paramPendingMask != 0; i++)
+  {
+    uint8_t paramCode = lcdFramePriority[i];
+    if ((paramPendingMask & (1UL << paramCode)) == 0)
+    {
+      continue;
+    }
+
+    char cmd[NEXTION_CMD_MAX];
+    uint8_t len = formatParam(cmd, paramCode);
+    int32_t val = paramPending[paramCode].val;
+
+    if (batch && !frameOpen && !paramSuppressed(paramCode, val, cmd, len))
+    {
+      if (len + LCD_BATCH_OVERHEAD > budget || nextionTxFree() < 3)
+      {
+        lcdStats.carriedOver++;
+        continue;
+      }
+      nextionSendRaw("ref_stop"); // opened on the first command that's actually written, so an idle frame costs nothing
+      budget -= LCD_BATCH_OVERHEAD;
+      frameOpen = true;
+      lcdStats.framesBatched++;
+    }
+
+    if ((!frameOpen || nextionTxFree() > 1) && writeParam(paramCode, val, cmd, len, budget)) // keep a slot for ref_star
+    {
+      paramPendingMask &= ~(1UL << paramCode);
+    }
+    else
+    {
+      lcdStats.carriedOver++; // a smaller, lower priority command may still fit, keep going
+    }
+  }
+
+  if (frameOpen)
+  {
+    nextionSendRaw("ref_star");
+  }
+}
+
+/**
+ * @brief Throttles the frame composer when the LCD is struggling to keep up and ramps it back up once the link
+ * is clean, called once per LCD frame
+ *
+ */
+void adaptLCDRate()
+{
+  static uint32_t lastOverflows;
+  static uint32_t lastTimeouts;
+  static uint32_t lastLatencySum;
+  static uint32_t lastLatencyCount;
+  static uint8_t cleanFrames;
+
+  uint32_t answered = nextionRxStats.latencyCount - lastLatencyCount;
+  uint32_t avgLatency = (answered != 0) ? (nextionRxStats.latencySum - lastLatencySum) / answered : 0;
+  bool congested = nextionRxStats.overflows != lastOverflows || nextionRxStats.timeouts != lastTimeouts ||
+                   avgLatency > LCD_ACK_SLOW_MS;
+
+  lastOverflows = nextionRxStats.overflows;
+  lastTimeouts = nextionRxStats.timeouts;
+  lastLatencySum = nextionRxStats.latencySum;
+  lastLatencyCount = nextionRxStats.latencyCount;
+
+  if (congested)
+  {
+    lcdRatePercent = max(lcdRatePercent / 2, LCD_RATE_MIN_PERCENT);
+    cleanFrames = 0;
+  }
+  else if (lcdRatePercent < 100 && ++cleanFrames >= LCD_RATE_CLEAN_FRAMES)
+  {
+    lcdRatePercent = min(lcdRatePercent + LCD_RATE_STEP_UP, 100);
+    cleanFrames = 0;
+  }
+}
+
+/**
+ * @brief Prints LCD link usage since the last call to the USB serial monitor: bytes/s actually written, bytes/s
+ * suppressed by the value cache, and the link budget at the current baud rate (10 bits per byte)
+ *
+ */
+void printLCDStats()
+{
+  static LCDLinkStats last;
+  static long unsigned int lastTime;
+
+  long unsigned int now = getTime();
+  long unsigned int elapsed = max(now - lastTime, 1UL);
+
+  Serial.print("LCD BYTES/S SENT:   ");
+  Serial.print((lcdStats.bytesSent - last.bytesSent) * 1000 / elapsed);
+  Serial.print("   SAVED:   ");
+  Serial.print((lcdStats.bytesSaved - last.bytesSaved) * 1000 / elapsed);
+  Serial.print("   BUDGET:   ");
+  Serial.print(lcdBaud / 10);
+  Serial.print("   CMDS SENT:   ");
+  Serial.print(lcdStats.cmdsSent - last.cmdsSent);
+  Serial.print("   CMDS SAVED:   ");
+  Serial.print(lcdStats.cmdsSaved - last.cmdsSaved);
+  Serial.print("   CARRIED OVER:   ");
+  Serial.print(lcdStats.carriedOver - last.carriedOver);
+  Serial.print("   FRAMES BATCHED:   ");
+  Serial.println(lcdStats.framesBatched - last.framesBatched);
+  Serial.print("LCD TX QUEUE DEPTH:   ");
+  Serial.print(nextionTxStats.depth);
+  Serial.print("   HIGH WATER:   ");
+  Serial.print(nextionTxStats.highWater);
+  Serial.print("   REPLACED:   ");
+  Serial.print(nextionTxStats.replaced);
+  Serial.print("   DROPPED:   ");
+  Serial.print(nextionTxStats.dropped);
+  Serial.print("   ADDT TIMEOUTS:   ");
+#ifdef LCD_TRACE
+  Serial.print(nextionTxStats.transparentTimeouts);
+  Serial.print("   TRACE OVERWRITTEN:   ");
+  Serial.println(traceOverwritten);
+#else
+  Serial.println(nextionTxStats.transparentTimeouts);
+#endif
+  Serial.print("LCD RATE %:   ");
+  Serial.print(lcdRatePercent);
+  Serial.print("   ACKS:   ");
+  Serial.print(nextionRxStats.acks);
+  Serial.print("   ERRORS:   ");
+  Serial.print(nextionRxStats.errors);
+  Serial.print("   LAST ERROR:   0x");
+  Serial.print(nextionRxStats.lastError, HEX);
+  Serial.print("   OVERFLOWS:   ");
+  Serial.print(nextionRxStats.overflows);
+  Serial.print("   TIMEOUTS:   ");
+  Serial.print(nextionRxStats.timeouts);
+  Serial.print("   AVG ACK MS:   ");
+  Serial.println((nextionRxStats.latencyCount != 0) ? nextionRxStats.latencySum / nextionRxStats.latencyCount : 0);
+
+  last = lcdStats;
+  lastTime = now;
+}
+
+/**
+ * @brief Prints how long after power-on each step of the boot happened, once the first live value reaches the LCD
+ *
+ */
+void reportBootTiming()
+{
+  bootTiming.reported = true;
+  Serial.print("Boot ms: setup ");
+  Serial.print(bootTiming.setupStart);
+  Serial.print("   CAN up ");
+  Serial.print(bootTiming.canStarted);
+  Serial.print("   LCD up ");
+  Serial.print(bootTiming.lcdReady);
+  Serial.print("   first RPM frame ");
+  Serial.print(bootTiming.firstRPM);
+  Serial.print("   first live value on LCD ");
+  Serial.print(bootTiming.firstLiveValue);
+  Serial.print(" (paramCode ");
+  Serial.print(bootTiming.firstLiveParam);
+  Serial.println(")");
+}
+
+/**
+ * @brief Get the Time object
+ *
+ * @return long unsigned int, time in milliseconds
+ */
+long unsigned int getTime()
+{
+  return millis();
+}
+
+/**
+ * @brief Flashy on sequence that is triggered when the vehicle is keyed on, plays in the background so CAN and the
+ * LCD come up at the same time
+ *
+ */
+void flashyOnSequence()
+{
+  startLEDAnimation(bootAnimation, BOOT_ANIMATION_FRAMES);
+}
+
+/**
+ * @brief Starts playing an animation on the tach LEDs, replacing any that's playing
+ *
+ * @param frames keyframes, must stay valid until the animation ends
+ * @param count number of keyframes
+ */
+void startLEDAnimation(const LEDKeyframe *frames, uint8_t count)
+{
+  noInterrupts();
+  ledAnim = frames;
+  ledAnimFrames = count;
+  ledAnimStep = 0;
+  ledAnimStepMs = 0;
+  writeTachLEDs(frames[0].pattern);
+  interrupts();
+  startLEDTimer();
+}
+
+/**
+ * @brief Ends the animation, the LEDs are left as they are for the caller to set, ledAnimTimer stops itself on its
+ * next tick if nothing else is blinking or fading
+ *
+ */
+void stopLEDAnimation()
+{
+  ledAnim = nullptr;
+}
+
+/**
+ * @brief Starts ledAnimTimer if it isn't running already
+ *
+ */
+void startLEDTimer()
+{
+  if (!ledTimerRunning)
+  {
+    ledTimerRunning = true;
+    ledAnimTimer.begin(ledAnimationTick, LED_ANIM_TICK_MS * 1000);
+  }
+}
+
+/**
+ * @brief ledAnimTimer interrupt, moves to the next keyframe once the current one has been shown long enough and
+ * hands the bar back to checkRPM()'s pattern after the last, steps blinks and fades, and stops the timer once
+ * there's nothing left to step
+ *
+ * @details No other interrupt touches the LED state, and loop() only does with interrupts off, so this runs without
+ * a critical section of its own, and never calls interrupts(), which would unmask the rest of the ISRs early.
+ */
+void ledAnimationTick()
+{
+  if (ledAnim != nullptr)
+  {
+    ledAnimStepMs += LED_ANIM_TICK_MS;
+    if (ledAnimStepMs >= ledAnim[ledAnimStep].ms)
+    {
+      ledAnimStepMs = 0;
+      if (++ledAnimStep < ledAnimFrames)
+      {
+        writeTachLEDs(ledAnim[ledAnimStep].pattern);
+      }
+      else
+      {
+        stopLEDAnimation();
+        writeTachLEDs(tachRPMPattern);
+      }
+    }
+  }
+
+  if (!tachEffectsTick() && ledAnim == nullptr)
+  {
+    ledAnimTimer.end();
+    ledTimerRunning = false;
   }
 }
 
 /**
- * @brief Changes all INTEGER parameters on the LCD
+ * @brief Sets up the PWM LEDs and their brightness, call before anything lights the bar
  *
- * @param paramCode an integer that determines what parameter is being changed
- * @param val the specified parameter's new integer value INCLUDING WARNINGS
+ * @param night start at tachNightBrightness instead of tachDayBrightness
  */
-void chngParamVal(int paramCode, int val)
+void initTachPWM(bool night)
 {
-  switch (paramCode)
+  analogWriteFrequency(LED_R, TACH_PWM_HZ); // sets LED_W's too, same submodule
+  for (uint8_t i = 0; i < TACH_LED_COUNT; i++)
   {
+    tachLevel[i] = night ? tachNightBrightness[i] : tachDayBrightness[i];
+    tachFadeTarget[i] = tachLevel[i];
+  }
+}
 
-  case 2:
-    if (currScreen != Params)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currECT = val;
-    Serial1.print("ETC.val=" + String(currECT));
-    endCommand();
-    break;
+/**
+ * @brief Fades the PWM LEDs to their day or night brightness over TACH_FADE_MS, call from loop(), not an ISR
+ *
+ */
+void setTachNightMode(bool night)
+{
+  noInterrupts();
+  for (uint8_t i = 0; i < TACH_LED_COUNT; i++)
+  {
+    tachFadeTarget[i] = night ? tachNightBrightness[i] : tachDayBrightness[i];
+    uint8_t diff = abs(tachFadeTarget[i] - tachLevel[i]);
+    tachFadeStep[i] = max(diff * LED_ANIM_TICK_MS / TACH_FADE_MS, 1);
+  }
+  interrupts();
+  startLEDTimer();
+}
 
-  case 3:
-    if (currScreen != Config1)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currFrontBP = val;
-    Serial1.print("FrontBP.val=" + String(currFrontBP));
-    endCommand();
-    break;
+/**
+ * @brief Blinks LEDs on top of whatever pattern is lit, an LED that isn't lit stays off, call from loop(), not an ISR
+ *
+ * @param bits TACH_BIT_* of the LEDs to blink, 0 stops blinking
+ * @param ms on and off time
+ */
+void setTachBlink(uint32_t bits, uint16_t ms)
+{
+  if (bits == tachBlinkBits)
+  {
+    return; // checkRPM() asks every frame
+  }
 
-  case 4:
-    if (currScreen != Config1)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currRearBP = val;
-    Serial1.print("RearBP.val=" + String(currRearBP));
-    endCommand();
-    break;
+  noInterrupts();
+  tachBlinkBits = bits;
+  tachBlinkMs = ms;
+  tachBlinkElapsed = 0;
+  tachBlinkDark = 0; // starts in the on half, so the blink shows up straight away
+  if (tachPattern != TACH_PATTERN_UNKNOWN)
+  {
+    applyTachLEDs();
+  }
+  interrupts();
+  if (bits != 0)
+  {
+    startLEDTimer();
+  }
+}
 
-  case 5:
-    if (currScreen != Params)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currFuelPSR = val;
-    Serial1.print("fuelPRSR.val=" + String(currFuelPSR));
-    endCommand();
-    break;
+/**
+ * @brief Steps blinks and fades by one LED_ANIM_TICK_MS, called from ledAnimTimer's interrupt
+ *
+ * @return true while anything is still blinking or fading
+ */
+bool tachEffectsTick()
+{
+  bool changed = false;
+  bool fading = false;
 
-  case 6:
-    if (currScreen == Config1 || currScreen == Config2 || currScreen == DragMode)
-    { // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-      currGearP = (int)val;
-      Serial1.print("gearPos.val=" + String(currGearP));
-      endCommand();
-    }
-    else
+  if (tachBlinkBits != 0)
+  {
+    tachBlinkElapsed += LED_ANIM_TICK_MS;
+    if (tachBlinkElapsed >= tachBlinkMs)
     {
-      return;
+      tachBlinkElapsed = 0;
+      tachBlinkDark ^= tachBlinkBits;
+      changed = true;
     }
-    break;
-
-  case 8:
-    if (currScreen != Params)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currMAP = val;
-    Serial1.print("Map.val=" + String(currMAP));
-    endCommand();
-    break;
-
-  case 9:
-    if (currScreen != Params)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currOilPSR = val;
-    Serial1.print("oilPRSR.val=" + String(currOilPSR));
-    endCommand();
-    break;
-
-  case 10:
-    if (currScreen != Config1)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currRPM = val;
-    Serial1.print("RPM.val=" + String(currRPM));
-    endCommand();
-    break;
+  }
 
-  case 13:
-    if (currScreen != Config2)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currTimerDelPic = val;
-    if (currTimerDelPic == 0)
-    {
-      Serial1.print("pic_Delta.pic=6");
-    }
-    else
+  for (uint8_t i = 0; i < TACH_LED_COUNT; i++)
+  {
+    int level = tachLevel[i];
+    int target = tachFadeTarget[i];
+    if (level != target)
     {
-      Serial1.print("pic_Delta.pic=7");
+      level = (level < target) ? min(level + tachFadeStep[i], target) : max(level - tachFadeStep[i], target);
+      tachLevel[i] = level;
+      fading |= (level != target);
+      changed = true;
     }
-    endCommand();
-    break;
+  }
 
-  case 14:
-    if (currScreen != DragMode || currScreen != Params)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    maxWSpd = val;
-    Serial1.print("MaxWS.val=" + String(maxWSpd));
-    endCommand();
-    break;
+  if (changed && tachPattern != TACH_PATTERN_UNKNOWN)
+  {
+    applyTachLEDs();
+  }
+  return tachBlinkBits != 0 || fading;
+}
 
-  case 18:
-    WARN_ECTO = val;
-    if (WARN_ECTO == 1)
-    {
-      Serial1.print("WARN_ECTO.pic=1");
-      endCommand();
-    }
-    else
+/**
+ * @brief Fills tachThresholds[] from gears[], call before CAN is started
+ *
+ */
+void initTachThresholds()
+{
+  for (uint8_t gear = 0; gear < GEAR_SLOTS; gear++)
+  {
+    int shift = gears[gear < 6 ? gear : 5];
+    for (uint8_t step = 0; step < TACH_STEPS - 1; step++)
     {
-      Serial1.print("WARN_ECTO.pic=4");
-      endCommand();
+      tachThresholds[gear].step[step] = (shift / TACH_STEPS) * (step + 1); // same rounding as the old per-frame math
     }
-    break;
+    tachThresholds[gear].shift = shift;
+    tachThresholds[gear].leadUs = (uint32_t)shiftReaction[gear < 6 ? gear : 5] * 1000;
+  }
+}
 
-  case 19:
-    WARN_FPRSR = val;
-    if (WARN_FPRSR == 1)
-    {
-      Serial1.print("WARN_FPRSR.pic=2");
-      endCommand();
-    }
-    else
-    {
-      Serial1.print("WARN_FPRSR.pic=4");
-      endCommand();
-    }
-    break;
+/**
+ * @brief Lights exactly the LEDs in pattern
+ *
+ * @param pattern TACH_BIT_* of the LEDs to light
+ */
+void writeTachLEDs(uint32_t pattern)
+{
+  tachPattern = pattern;
+  applyTachLEDs();
+}
 
-  case 20:
-    WARN_OTEMP = val;
-    if (WARN_OTEMP == 1)
-    {
-      Serial1.print("WARN_OTEMP.pic=3");
-      endCommand();
-    }
-    else
-    {
-      Serial1.print("WARN_OTEMP.pic=4");
-      endCommand();
-    }
-    break;
+/**
+ * @brief Puts tachPattern, less any blinking LED in its off half, on the pins: one store turns the lit GPIO LEDs on
+ * (driven low) and one turns the rest off, the PWM LEDs get their brightness or are held off
+ *
+ */
+void applyTachLEDs()
+{
+  uint32_t lit = tachPattern & ~tachBlinkDark;
+  GPIO7_DR_CLEAR = lit & TACH_GPIO_BITS; // ON is LOW
+  GPIO7_DR_SET = ~lit & TACH_GPIO_BITS;
 
-  case 21:
-    WARN_OPRSR = val;
-    if (WARN_OPRSR == 1)
-    {
-      Serial1.print("WARN_OPRSR.pic=10");
-      endCommand();
-    }
-    else
+  for (uint8_t i = 0; i < TACH_LED_COUNT; i++)
+  {
+    if (tachLEDs[i].pwm)
     {
-      Serial1.print("WARN_OPRSR.pic=4");
-      endCommand();
+      analogWrite(tachLEDs[i].pin, (lit & tachLEDs[i].bit) ? TACH_BRIGHTNESS_FULL - tachLevel[i] : TACH_PWM_OFF); // low time lights it
     }
-    break;
+  }
+}
 
-  case 22:
-    if (currScreen != Params)
-    {
-      return;
-    } // if not on proper screen, return. Changing params that are not on screen cause errors & lag w/ screen
-    currOilTemp = val;
-    Serial1.print("oilTEMP.val=" + String(currOilTemp));
-    endCommand();
-    break;
+/**
+ * @brief Adds an RPM reading to the slope history, a reading for a new gear or after a gap in the readings starts
+ * the history over, runs in the RPM mailbox ISR with the fast path on
+ *
+ * @param rpm the RPM just decoded
+ * @param gear the gear it was decoded in
+ */
+void recordRPM(int rpm, int gear)
+{
+  uint32_t now = micros();
+  if (gear != rpmHistoryGear || (rpmHistoryCount > 0 && now - rpmHistory[rpmHistoryHead].usec > RPM_HISTORY_GAP_US))
+  {
+    rpmHistoryGear = gear;
+    rpmHistoryCount = 0;
+  }
+  else if (rpmHistoryCount > 0 && now - rpmHistory[rpmHistoryHead].usec < RPM_SAMPLE_MIN_US)
+  {
+    rpmHistory[rpmHistoryHead].rpm = rpm; // same frame seen twice, or a burst, keep the newest
+    return;
+  }
+
+  rpmHistoryHead = (rpmHistoryHead + 1) % RPM_HISTORY;
+  rpmHistory[rpmHistoryHead].usec = now;
+  rpmHistory[rpmHistoryHead].rpm = rpm;
+  if (rpmHistoryCount < RPM_HISTORY)
+  {
+    rpmHistoryCount++;
   }
 }
 
-/* Returns time from msecs to a string in the format '00:00' */
 /**
- * @brief Returns time from milliseconds to a string in the format '00:00'
+ * @brief Least-squares slope of the RPM history, integer sums with times relative to the newest sample, call from
+ * loop() only
+ *
+ * The history is copied with interrupts off so the RPM ISR can't add a sample halfway through. With the gap reset
+ * in recordRPM() the samples span at most RPM_HISTORY * RPM_HISTORY_GAP_US, which keeps the sums well inside int64.
  *
- * @param val time in milliseconds
- * @return String in the format "00:00"
+ * @return int32_t RPM per second, 0 until there are RPM_HISTORY_MIN samples or once the newest is a gap old
  */
-String convMSec_to_TForm(long unsigned int val)
+int32_t rpmSlope()
 {
-  long unsigned int holder = val;
-  int secs = (holder % 60000) / 1000;
-  holder -= secs;
-  int mins = (holder == 0) ? 0 : holder / 60000;
+  RPMSample samples[RPM_HISTORY];
+  noInterrupts();
+  uint8_t count = rpmHistoryCount;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    samples[i] = rpmHistory[(rpmHistoryHead + RPM_HISTORY - i) % RPM_HISTORY]; // newest first
+  }
+  interrupts();
+
+  if (count < RPM_HISTORY_MIN || micros() - samples[0].usec > RPM_HISTORY_GAP_US)
+  {
+    return 0;
+  }
 
-  String build = String(mins) + ":";
-  build += (secs < 10) ? "0" + String(secs) : String(secs);
+  uint32_t newest = samples[0].usec;
+  int64_t sumT = 0, sumR = 0, sumTT = 0, sumTR = 0;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    const RPMSample &s = samples[i];
+    int64_t t = -(int64_t)(newest - s.usec); // <= 0, keeps the sums small
+    sumT += t;
+    sumR += s.rpm;
+    sumTT += t * t;
+    sumTR += t * s.rpm;
+  }
 
-  return build;
+  int64_t n = count;
+  int64_t den = n * sumTT - sumT * sumT;
+  if (den <= 0)
+  {
+    return 0; // every sample at the same time
+  }
+  return (int32_t)((n * sumTR - sumT * sumR) * 1000000 / den);
 }
 
 /**
- * @brief Get the Time object
+ * @brief RPM the engine will be at leadUs from now if it keeps accelerating like it has been, never below the
+ * last reading (decelerating never fires the light early) and never more than SHIFT_MAX_LEAD_RPM above it
  *
- * @return long unsigned int, time in milliseconds
  */
-long unsigned int getTime()
+int projectedRPM(uint32_t leadUs)
 {
-  return millis();
+  noInterrupts();
+  RPMSample last = rpmHistory[rpmHistoryHead];
+  interrupts();
+  int32_t slope = rpmSlope();
+  if (slope <= 0)
+  {
+    return last.rpm;
+  }
+  int64_t ahead = (int64_t)slope * (leadUs + (micros() - last.usec)) / 1000000;
+  return last.rpm + (int)min(ahead, (int64_t)SHIFT_MAX_LEAD_RPM);
 }
 
 /**
- * @brief Flashy on sequence that is triggered when the vehicle is keyed on
+ * @brief Should the shift light be on, either RPM is at the shift point or it's projected to be by the time the
+ * driver reacts
  *
  */
-void flashyOnSequence()
+bool shiftDue(int gear)
 {
-  int t1 = 90;
-  int t2 = 80;
-  int t3 = 1000;
-
-  /* Turn off lights */
-  digitalWrite(LED_G, OFF);
-  digitalWrite(LED_O, OFF);
-  digitalWrite(LED_R, OFF);
-  digitalWrite(LED_W, OFF);
-
-  delay(100);
-
-  /* Actual light sequence */
-  digitalWrite(LED_G, ON);
-  delay(t1);
-  digitalWrite(LED_O, ON);
-  delay(t1);
-  digitalWrite(LED_R, ON);
-  delay(t1);
-  digitalWrite(LED_W, ON);
-  delay(t2);
-  digitalWrite(LED_W, OFF);
-  delay(t2);
-  digitalWrite(LED_W, ON);
-  delay(t2);
-  digitalWrite(LED_W, OFF);
-  delay(t1);
-  digitalWrite(LED_R, OFF);
-  delay(t1);
-  digitalWrite(LED_O, OFF);
-  delay(t1);
-  digitalWrite(LED_G, OFF);
-  delay(t3);
-  return;
-}
-
-/**
- * @brief Turns on tachometer lights based on current RPM value and gear
+  const TachThresholds &t = tachThresholds[gear & GEAR_MASK];
+  if (currRPM >= t.shift)
+  {
+    return true;
+  }
+  return t.leadUs != 0 && rpmHistoryCount > 0 && projectedRPM(t.leadUs) >= t.shift;
+}
+
+/**
+ * @brief Turns on tachometer lights based on current RPM value and gear, a table lookup and the LED registers are
+ * only written when the pattern changes
  *
  */
 void checkRPM()
@@ -858,68 +2044,89 @@ void checkRPM()
   }
   */
 
-  if (currRPM <= 0)
-  {
-    digitalWrite(LED_G, OFF);
-    digitalWrite(LED_O, OFF);
-    digitalWrite(LED_R, OFF);
-    digitalWrite(LED_W, OFF);
-  }
-  else if (currRPM <= (gears[currGearP] / 4) * 1)
+  const TachThresholds &t = tachThresholds[currGearP & GEAR_MASK];
+  uint8_t level = (currRPM > 0) + (currRPM > t.step[0]) + (currRPM > t.step[1]) + (currRPM > t.step[2]);
+  uint32_t pattern = tachPatterns[level];
+
+  shiftLightOn = currRPM > 0 && shiftDue(currGearP);
+  if (shiftLightOn)
   {
-    digitalWrite(LED_G, ON);
-    digitalWrite(LED_O, OFF);
-    digitalWrite(LED_R, OFF);
-    digitalWrite(LED_W, OFF);
+    pattern = TACH_PATTERN_SHIFT;
   }
-  else if (currRPM <= (gears[currGearP] / 4) * 2)
+
+  tachRPMPattern = pattern;
+  if (ledAnim != nullptr)
   {
-    digitalWrite(LED_G, ON);
-    digitalWrite(LED_O, ON);
-    digitalWrite(LED_R, OFF);
-    digitalWrite(LED_W, OFF);
+    if (currRPM <= 0)
+    {
+      return; // the animation has the bar until it ends
+    }
+    stopLEDAnimation(); // engine's running, the tach matters more
   }
-  else if (currRPM <= (gears[currGearP] / 4) * 3)
+
+  setTachBlink(currRPM >= t.shift + TACH_OVERREV_RPM ? TACH_BIT_W : 0, TACH_OVERREV_BLINK_MS); // over-rev
+
+  if (pattern != tachPattern) // most frames don't move the bar
   {
-    digitalWrite(LED_G, ON);
-    digitalWrite(LED_O, ON);
-    digitalWrite(LED_R, ON);
-    digitalWrite(LED_W, OFF);
+    noInterrupts(); // ledAnimTimer puts the bar on the pins too
+    writeTachLEDs(pattern);
+    interrupts();
   }
 }
 
 /**
- * @brief Code used to operate in conjunction with the "collective's" push-button (not rocker switches)
+ * @brief Collective's page push-button (not rocker switches) ISR, only works out the next page and leaves it in
+ * pgBtnRequest for handlePageBtn()
  *
+ * @details chngScrn() clears the LCD queues and replays the page, which loop() is in the middle of using, so it
+ * never runs here. Presses closer together than PAGE_BTN_DEBOUNCE_MS are ignored, two presses before loop() gets
+ * to the first one move on two pages.
  */
 void pageBtnPressed()
 {
-  if (analogRead(pgBtnPin) >= 1000 && pgBtnBool == false) // Originally digitalRead was was fidgety, switched to analogRead to get a better reading
+  uint32_t now = millis();
+  if (analogRead(pgBtnPin) >= 1000 && now - pgBtnLastPress >= PAGE_BTN_DEBOUNCE_MS) // Originally digitalRead was was fidgety, switched to analogRead to get a better reading
   {
-    pgBtnBool = true; // Debounce, prevents button from spamming "next page" w/o transitioning to the next page
+    pgBtnLastPress = now;
+    pgBtnRequest = nextNormScrn((pgBtnRequest >= 0) ? (Screen)pgBtnRequest : currScreen);
+  }
+}
 
-    if (currScreen == Config1)
-    {
-      chngScrn(Config2);
-    }
-    else if (currScreen == Config2)
-    {
-      chngScrn(DragMode);
-    }
-    else if (currScreen == DragMode)
-    {
-      chngScrn(Params);
-    }
-    else if (currScreen == Params)
-    {
-      chngScrn(Config1);
-    }
-    delay(300);
+/**
+ * @brief The page the page button moves on to from a normal screen
+ *
+ */
+Screen nextNormScrn(Screen from)
+{
+  switch (from)
+  {
+  case Config1:
+    return Config2;
+  case Config2:
+    return DragMode;
+  case DragMode:
+    return Params;
+  case Params:
+    return Config1;
+  default:
+    return from;
   }
-  else if (analogRead(pgBtnPin) >= 1000 && pgBtnBool == true)
+}
+
+/**
+ * @brief Changes to the page the page button asked for, if it did, called from loop()
+ *
+ */
+void handlePageBtn()
+{
+  noInterrupts();
+  int8_t page = pgBtnRequest;
+  pgBtnRequest = -1;
+  interrupts();
+
+  if (page >= 0)
   {
-    pgBtnBool = false;
-    return;
+    chngScrn((Screen)page);
   }
 }
 
@@ -949,14 +2156,74 @@ void chngScrnSlowDown()
   }
 }
 
+#ifdef BENCH_CONVERSIONS
+/**
+ * @brief Compares the cycle cost of the old double unit conversions against the CANSignal fixed-point
+ * pipeline for the same channels (ECT, oil pressure, throttle, wheelspeed), results go to the USB serial monitor
+ *
+ * The double side is the pre-CANSignal decode expressions as they were, including the wheelspeed multiply by
+ * 1.609344 that M150_WheelSpeed now corrects to a divide, so the two loops don't compute the same wheelspeed.
+ *
+ * Build with "build_flags = -D BENCH_CONVERSIONS" in platformio.ini to run it once at startup
+ */
+void benchmarkConversions()
+{
+  const uint16_t iterations = 1000;
+  uint8_t buf[8] = {0x96, 0x0F, 0x03, 0xE8, 0x0F, 0x9C, 0x0F, 0xA0};
+  volatile int32_t sink = 0;
+
+  uint32_t start = ARM_DWT_CYCCNT;
+  for (uint16_t i = 0; i < iterations; i++)
+  {
+    buf[0] = i;
+    buf[7] = i;
+
+    int ect = buf[0];
+    ect = ((ect * 10) - 400) / 10;
+    ect = (ect * 1.8) + 32;
+    int oilPSR = buf[6];
+    oilPSR = oilPSR << 8;
+    oilPSR |= buf[7];
+    oilPSR = (oilPSR * 0.145038) / 10;
+    int temp = buf[0];
+    temp = temp << 8;
+    temp |= buf[1];
+    int thrtl = temp * 0.1;
+    int wheelSpeed = buf[6];
+    wheelSpeed = wheelSpeed << 8;
+    wheelSpeed |= buf[7];
+    wheelSpeed = wheelSpeed * 0.1;
+    wheelSpeed *= 1.609344; // the baseline's km/h "to mph", really a multiply the wrong way, kept to time what ran
+    sink = ect + oilPSR + thrtl + wheelSpeed;
+  }
+  uint32_t doubleCycles = ARM_DWT_CYCCNT - start;
+
+  start = ARM_DWT_CYCCNT;
+  for (uint16_t i = 0; i < iterations; i++)
+  {
+    buf[0] = i;
+    buf[7] = i;
+
+    sink = M150_ECT::value(buf) + M150_OilPSR::value(buf) + M150_Throttle::value(buf) + M150_WheelSpeed::value(buf);
+  }
+  uint32_t fixedCycles = ARM_DWT_CYCCNT - start;
+  (void)sink;
+
+  Serial.print("Conversion cycles per frame (ECT + oilPSR + thrtl + wheelspeed), double: ");
+  Serial.print(doubleCycles / iterations);
+  Serial.print("   fixed-point: ");
+  Serial.println(fixedCycles / iterations);
+}
+#endif
+
 /**
  * @brief All commands ran before the execution of the main loop
  *
  */
 void setup()
 {
+  bootTiming.setupStart = getTime();
   Serial.begin(112500);
-  Serial1.begin(9600); // Changed from 9600, if LCD stops responding change this value back to 9600
 
   /* Copied from FlexCAN setup() CAN Message Recieved example */
   pinMode(6, OUTPUT);
@@ -971,33 +2238,89 @@ void setup()
 
   digitalWrite(13, HIGH);
 
-  flashyOnSequence();
+  /* analogWriteResolution() is global, every analogWrite() shares it: the tach PWM LEDs' brightness (TACH_PWM_RES)
+     and the gear output on analogOutputPin (GEAR_OUT_STEP per gear) are both 8 bit, so it's set once, here */
+  analogWriteResolution(TACH_PWM_RES);
+
+  initTachThresholds();
+  initGearEstimator();
+#ifdef TACH_NIGHT_MODE // build with -D TACH_NIGHT_MODE to start with the LEDs dimmed, setTachNightMode() switches later
+  initTachPWM(true);
+#else
+  initTachPWM(false);
+#endif
+  flashyOnSequence(); // plays from ledAnimTimer while CAN and the LCD come up
+
+#ifdef BENCH_CONVERSIONS
+  benchmarkConversions();
+#endif
+
+  initCANDispatch();
 
   Can0.begin();
   Can0.setBaudRate(1000000); // MoTeC Bitrate is 1Mbps, translates to 1000000 baud
   Can0.setMaxMB(16);
   Can0.enableFIFO();
+  setupCANFastPath();
+  setupCANFilters();
   Can0.enableFIFOInterrupt();
   Can0.onReceive(CANmsgRecieve);
   Can0.mailboxStatus();
+  bootTiming.canStarted = getTime(); // frames from here on wait in their slots while the LCD link comes up
+
+  nextionTxBegin();
+
+  uint32_t storedBaud;
+  EEPROM.get(LCD_BAUD_EEPROM_ADDR, storedBaud);
+  uint32_t negotiated = nextionNegotiateBaud(storedBaud); // was hard-coded to 9600, faster rates now have to prove themselves first
+  lcdBaud = (negotiated != 0) ? negotiated : NEXTION_DEFAULT_BAUD;
+  if (negotiated != 0 && negotiated != storedBaud) // no LCD answering says nothing about the rate, keep the saved one
+  {
+    EEPROM.put(LCD_BAUD_EEPROM_ADDR, negotiated);
+  }
+  nextionEnableAcks();
 
   attachInterrupt(digitalPinToInterrupt(41), pageBtnPressed, HIGH); // When "Page" btn is pressed on collective, change pagest
 
   // Change to opening screen
   chngScrn(Params);
+  bootTiming.lcdReady = getTime();
 }
 
 void loop()
 {
-  /* Redundant code to ensure flip flop of isSilentTime */
-  if (getTime() - timeHolder >= silenceTime)
+  handlePageBtn();
+  processCANFrames();
+  nextionRxPoll();
+#ifdef LCD_TRACE // build with -D LCD_TRACE for the DragMode waveform, needs the HMI change in lcdTrace.h
+  traceTick();
+#endif
+  composeLCDFrame();
+#ifdef LCD_TRACE
+  traceFlush();
+#endif
+  nextionTxPump();
+
+#if defined(REPORT_CAN_STATS) || defined(REPORT_LCD_STATS)
+  if (getTime() - showTimeHolder >= 5000) // build with -D REPORT_CAN_STATS / -D REPORT_LCD_STATS to print counters every 5s
   {
-    isSilentTime = !isSilentTime;
-    timeHolder = getTime();
+    showTimeHolder = getTime();
+#ifdef REPORT_CAN_STATS
+    printCANStats();
+#endif
+#ifdef REPORT_LCD_STATS
+    printLCDStats();
+#endif
   }
+#endif
 
   if (currRPM > 0)
   {
-    chngParamVal(12, (double)getTime());
+    chngParamVal(12, (int)getTime());
+  }
+
+  if (!bootTiming.reported && bootTiming.firstLiveValue != BOOT_NOT_YET)
+  {
+    reportBootTiming();
   }
 }
\ No newline at end of file
@@ -0,0 +1,752 @@
+#include <nextionCommand.h>
+
+/**
+ * @brief Room kept free at the end of the buffer for the terminator
+ *
+ */
+#define NEXTION_BODY_MAX (NEXTION_CMD_MAX - 3)
+
+/**
+ * @brief Link rates tried by nextionNegotiateBaud(), fastest first
+ *
+ */
+static const uint32_t nextionBaudRates[] = {921600, 512000, 115200, NEXTION_DEFAULT_BAUD};
+#define NEXTION_BAUD_RATE_COUNT (sizeof(nextionBaudRates) / sizeof(nextionBaudRates[0]))
+
+struct NextionTxCmd
+{
+  uint8_t len;
+  uint8_t dataLen;                  // raw bytes after the command for a transparent transfer (addt), 0 otherwise
+  uint8_t key;                      // NEXTION_KEY_NONE or the paramCode it updates
+  char buf[NEXTION_CMD_MAX];        // the command, followed by the transparent data
+};
+
+/**
+ * @brief Where a transparent transfer is at, nothing else can go out to the LCD until it's back to idle
+ *
+ */
+enum NextionTransparentState
+{
+  NEXTION_TP_IDLE,
+  NEXTION_TP_WAIT_READY,            // addt sent, waiting for 0xFE, the command stays at the head of the queue
+  NEXTION_TP_SEND_DATA,             // 0xFE recieved, data goes out as soon as it fits
+  NEXTION_TP_WAIT_DONE              // data sent, waiting for 0xFD
+};
+
+static NextionTxCmd nextionTxQueue[NEXTION_TX_DEPTH];
+static uint8_t nextionTxHead;       // next command handed to Serial1
+static uint8_t nextionTxCount;
+static uint8_t nextionSerialTxMem[NEXTION_TX_SERIAL_MEM];
+
+NextionTxStats nextionTxStats;
+
+static volatile uint8_t nextionTpState;
+static long unsigned int nextionTpStart; // millis() the current transparent state was entered
+
+static uint8_t nextionRxBuf[NEXTION_RX_MAX];
+static uint8_t nextionRxLen;
+static uint8_t nextionRxTermCount; // consecutive 0xFF at the end of nextionRxBuf
+
+static bool nextionAcksOn;          // bkcmd=3, every command gets answered
+static uint32_t nextionInflight[NEXTION_INFLIGHT_MAX]; // millis() each unanswered command went to Serial1
+static uint8_t nextionInflightHead;
+static uint8_t nextionInflightCount;
+
+NextionRxStats nextionRxStats;
+
+/**
+ * @brief Copies a string into the command buffer, stopping short of the terminator's space
+ *
+ * @param buf the command buffer
+ * @param len current command length, advanced past the copied characters
+ * @param str null terminated string to append
+ */
+static void appendStr(char *buf, uint8_t &len, const char *str)
+{
+  while (*str != '\0' && len < NEXTION_BODY_MAX)
+  {
+    buf[len++] = *str++;
+  }
+}
+
+/**
+ * @brief Appends a single character
+ *
+ */
+static void appendChar(char *buf, uint8_t &len, char c)
+{
+  if (len < NEXTION_BODY_MAX)
+  {
+    buf[len++] = c;
+  }
+}
+
+/**
+ * @brief Appends an unsigned integer in decimal, zero padded to at least minDigits
+ *
+ * @param buf the command buffer
+ * @param len current command length, advanced past the digits
+ * @param val the value to append
+ * @param minDigits pads with leading zeros up to this many digits
+ */
+static void appendUInt(char *buf, uint8_t &len, uint32_t val, uint8_t minDigits)
+{
+  char digits[10];
+  uint8_t count = 0;
+  do
+  {
+    digits[count++] = '0' + (val % 10);
+    val /= 10;
+  } while (val != 0);
+
+  while (count < minDigits)
+  {
+    digits[count++] = '0';
+  }
+  while (count > 0)
+  {
+    appendChar(buf, len, digits[--count]);
+  }
+}
+
+/**
+ * @brief Appends a signed integer in decimal
+ *
+ */
+static void appendInt(char *buf, uint8_t &len, int32_t val)
+{
+  if (val < 0)
+  {
+    appendChar(buf, len, '-');
+  }
+  appendUInt(buf, len, (val < 0) ? -(uint32_t)val : (uint32_t)val, 1);
+}
+
+/**
+ * @brief Appends the 0xFF 0xFF 0xFF end of command marker, there is always room for it
+ *
+ * @return uint8_t the final command length
+ */
+static uint8_t appendTerminator(char *buf, uint8_t len)
+{
+  buf[len++] = (char)NEXTION_TERMINATOR;
+  buf[len++] = (char)NEXTION_TERMINATOR;
+  buf[len++] = (char)NEXTION_TERMINATOR;
+  return len;
+}
+
+/**
+ * @brief Formats a command that takes no value, e.g. "page Params"
+ *
+ * @param buf output buffer, at least NEXTION_CMD_MAX bytes
+ * @param cmd the instruction
+ * @return uint8_t length of the command including the terminator
+ */
+uint8_t nextionFormatRaw(char *buf, const char *cmd)
+{
+  uint8_t len = 0;
+  appendStr(buf, len, cmd);
+  return appendTerminator(buf, len);
+}
+
+/**
+ * @brief Formats a numeric assignment, e.g. ("RPM.val=", 9500) -> RPM.val=9500
+ *
+ * @param buf output buffer, at least NEXTION_CMD_MAX bytes
+ * @param prefix component and attribute up to and including the '='
+ * @param val the value to assign
+ * @return uint8_t length of the command including the terminator
+ */
+uint8_t nextionFormatInt(char *buf, const char *prefix, int32_t val)
+{
+  uint8_t len = 0;
+  appendStr(buf, len, prefix);
+  appendInt(buf, len, val);
+  return appendTerminator(buf, len);
+}
+
+/**
+ * @brief Formats a fixed-point value into a text component, e.g. ("Batt.txt=", 1234, 2) -> Batt.txt="12.34"
+ *
+ * @param buf output buffer, at least NEXTION_CMD_MAX bytes
+ * @param prefix component and attribute up to and including the '='
+ * @param val the value multiplied by 10^decimals
+ * @param decimals digits after the decimal point
+ * @return uint8_t length of the command including the terminator
+ */
+uint8_t nextionFormatFixedTxt(char *buf, const char *prefix, int32_t val, uint8_t decimals)
+{
+  uint32_t divisor = 1;
+  for (uint8_t i = 0; i < decimals; i++)
+  {
+    divisor *= 10;
+  }
+  uint32_t mag = (val < 0) ? -(uint32_t)val : (uint32_t)val;
+
+  uint8_t len = 0;
+  appendStr(buf, len, prefix);
+  appendChar(buf, len, '"');
+  if (val < 0)
+  {
+    appendChar(buf, len, '-');
+  }
+  appendUInt(buf, len, mag / divisor, 1);
+  if (decimals != 0)
+  {
+    appendChar(buf, len, '.');
+    appendUInt(buf, len, mag % divisor, decimals);
+  }
+  appendChar(buf, len, '"');
+  return appendTerminator(buf, len);
+}
+
+/**
+ * @brief Formats milliseconds as "m:ss" into a text component, e.g. ("timer_R1.txt=", 83000) -> timer_R1.txt="1:23"
+ *
+ * @param buf output buffer, at least NEXTION_CMD_MAX bytes
+ * @param prefix component and attribute up to and including the '='
+ * @param msec time in milliseconds
+ * @return uint8_t length of the command including the terminator
+ */
+uint8_t nextionFormatTimeTxt(char *buf, const char *prefix, uint32_t msec)
+{
+  uint8_t len = 0;
+  appendStr(buf, len, prefix);
+  appendChar(buf, len, '"');
+  appendUInt(buf, len, msec / 60000, 1);
+  appendChar(buf, len, ':');
+  appendUInt(buf, len, (msec % 60000) / 1000, 2);
+  appendChar(buf, len, '"');
+  return appendTerminator(buf, len);
+}
+
+/**
+ * @brief Formats a waveform transparent transfer command, e.g. (2, 0, 8) -> addt 2,0,8
+ *
+ * @param buf output buffer, at least NEXTION_CMD_MAX bytes
+ * @param objId the waveform's component id
+ * @param channel waveform channel, 0-3
+ * @param qty number of data bytes that will follow
+ * @return uint8_t length of the command including the terminator
+ */
+uint8_t nextionFormatAddt(char *buf, uint8_t objId, uint8_t channel, uint8_t qty)
+{
+  uint8_t len = 0;
+  appendStr(buf, len, "addt ");
+  appendUInt(buf, len, objId, 1);
+  appendChar(buf, len, ',');
+  appendUInt(buf, len, channel, 1);
+  appendChar(buf, len, ',');
+  appendUInt(buf, len, qty, 1);
+  return appendTerminator(buf, len);
+}
+
+/**
+ * @brief Gives Serial1 a bigger TX buffer, call once before anything is sent to the LCD
+ *
+ */
+void nextionTxBegin()
+{
+  Serial1.addMemoryForWrite(nextionSerialTxMem, sizeof(nextionSerialTxMem));
+}
+
+/**
+ * @brief Finds the queued command with a given key
+ *
+ * @return int8_t its index in nextionTxQueue, or -1 if there isn't one
+ */
+static int8_t nextionTxFind(uint8_t key)
+{
+  if (key == NEXTION_KEY_NONE)
+  {
+    return -1;
+  }
+  for (uint8_t i = 0; i < nextionTxCount; i++)
+  {
+    uint8_t idx = (nextionTxHead + i) % NEXTION_TX_DEPTH;
+    if (nextionTxQueue[idx].key == key)
+    {
+      return idx;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief Checks whether a command with this key would be dropped if it was written now
+ *
+ */
+bool nextionTxFull(uint8_t key)
+{
+  return nextionTxCount == NEXTION_TX_DEPTH && nextionTxFind(key) < 0;
+}
+
+/**
+ * @brief Number of commands that can still be queued before the queue is full
+ *
+ */
+uint8_t nextionTxFree()
+{
+  return NEXTION_TX_DEPTH - nextionTxCount;
+}
+
+/**
+ * @brief Throws away everything still queued, e.g. commands for a page that's no longer shown
+ *
+ */
+void nextionTxClear()
+{
+  // an addt the LCD has already seen keeps its data, or the LCD would swallow the next commands as data
+  nextionTxCount = (nextionTpState == NEXTION_TP_WAIT_READY || nextionTpState == NEXTION_TP_SEND_DATA) ? 1 : 0;
+  nextionTxStats.depth = 0;
+}
+
+/**
+ * @brief Moves whole queued commands into Serial1's TX buffer while they fit, never waits
+ *
+ */
+void nextionTxPump()
+{
+  while (true)
+  {
+    bool timedOut = millis() - nextionTpStart > NEXTION_TP_TIMEOUT_MS;
+    if (nextionTpState == NEXTION_TP_WAIT_DONE)
+    {
+      if (!timedOut)
+      {
+        break;
+      }
+      nextionTxStats.transparentTimeouts++;
+      nextionTpState = NEXTION_TP_IDLE;
+    }
+
+    if (nextionTxCount == 0)
+    {
+      break;
+    }
+    const NextionTxCmd &cmd = nextionTxQueue[nextionTxHead];
+
+    if (nextionTpState == NEXTION_TP_WAIT_READY)
+    {
+      if (!timedOut)
+      {
+        break;
+      }
+      nextionTxStats.transparentTimeouts++; // the LCD never asked for the data, give up on it
+      nextionTpState = NEXTION_TP_IDLE;
+    }
+    else if (nextionTpState == NEXTION_TP_SEND_DATA)
+    {
+      if (Serial1.availableForWrite() < cmd.dataLen)
+      {
+        break;
+      }
+      Serial1.write((const uint8_t *)cmd.buf + cmd.len, cmd.dataLen);
+      nextionTpState = NEXTION_TP_WAIT_DONE;
+      nextionTpStart = millis();
+    }
+    else
+    {
+      if (Serial1.availableForWrite() < cmd.len)
+      {
+        break;
+      }
+      Serial1.write((const uint8_t *)cmd.buf, cmd.len);
+
+      if (cmd.dataLen != 0)
+      {
+        nextionTpState = NEXTION_TP_WAIT_READY; // stays at the head until the data is out
+        nextionTpStart = millis();
+        continue;
+      }
+      if (nextionAcksOn && nextionInflightCount < NEXTION_INFLIGHT_MAX)
+      {
+        nextionInflight[(nextionInflightHead + nextionInflightCount++) % NEXTION_INFLIGHT_MAX] = millis();
+      }
+    }
+
+    nextionTxHead = (nextionTxHead + 1) % NEXTION_TX_DEPTH;
+    nextionTxCount--;
+  }
+  nextionTxStats.depth = nextionTxCount;
+}
+
+/**
+ * @brief Blocks until every queued command has been handed to Serial1, only for setup() (baud negotiation)
+ *
+ */
+void nextionTxDrain()
+{
+  while (nextionTxCount > 0)
+  {
+    nextionTxPump();
+    yield();
+  }
+}
+
+/**
+ * @brief Queues a formatted command for the LCD, never blocks
+ *
+ * @param buf the command, including its terminator
+ * @param len length of the command
+ * @param key replaces the queued command with the same key, NEXTION_KEY_NONE always adds a new command
+ * @return true if the command was queued, false if the queue was full and it was dropped
+ */
+bool nextionWrite(const char *buf, uint8_t len, uint8_t key)
+{
+  return nextionWriteTransparent(buf, len, NULL, 0, key);
+}
+
+/**
+ * @brief Queues a command followed by raw data for a transparent transfer (addt), the data only goes out once
+ * the LCD answers the command with 0xFE, and nothing else goes out until it answers the data with 0xFD
+ *
+ * @param buf the command, including its terminator
+ * @param len length of the command
+ * @param data the raw bytes, len + dataLen has to fit into NEXTION_CMD_MAX
+ * @param dataLen number of raw bytes, 0 for a normal command
+ * @param key replaces the queued command with the same key, NEXTION_KEY_NONE always adds a new command
+ * @return true if the command was queued, false if the queue was full and it was dropped
+ */
+bool nextionWriteTransparent(const char *buf, uint8_t len, const uint8_t *data, uint8_t dataLen, uint8_t key)
+{
+  if (len + dataLen > NEXTION_CMD_MAX)
+  {
+    return false;
+  }
+
+  int8_t idx = nextionTxFind(key);
+  if (idx >= 0)
+  {
+    nextionTxStats.replaced++;
+  }
+  else if (nextionTxCount == NEXTION_TX_DEPTH)
+  {
+    nextionTxStats.dropped++;
+    return false;
+  }
+  else
+  {
+    idx = (nextionTxHead + nextionTxCount) % NEXTION_TX_DEPTH;
+    nextionTxCount++;
+  }
+
+  NextionTxCmd &cmd = nextionTxQueue[idx];
+  memcpy(cmd.buf, buf, len);
+  memcpy(cmd.buf + len, data, dataLen);
+  cmd.len = len;
+  cmd.dataLen = dataLen;
+  cmd.key = key;
+
+  nextionTxStats.depth = nextionTxCount;
+  if (nextionTxCount > nextionTxStats.highWater)
+  {
+    nextionTxStats.highWater = nextionTxCount;
+  }
+  return true;
+}
+
+/**
+ * @brief Has the LCD answer every command (bkcmd=3), so nextionRxPoll() can time them, call after the baud rate
+ * is settled
+ *
+ */
+void nextionEnableAcks()
+{
+  nextionSendRaw("bkcmd=3");
+  nextionTxDrain();
+  nextionInflightCount = 0;
+  nextionAcksOn = true;
+}
+
+/**
+ * @brief Matches an answer from the LCD with the oldest unanswered command
+ *
+ */
+static void nextionAnswered()
+{
+  if (nextionInflightCount == 0)
+  {
+    return;
+  }
+  nextionRxStats.latencySum += millis() - nextionInflight[nextionInflightHead];
+  nextionRxStats.latencyCount++;
+  nextionInflightHead = (nextionInflightHead + 1) % NEXTION_INFLIGHT_MAX;
+  nextionInflightCount--;
+}
+
+/**
+ * @brief Sorts a complete frame from the LCD into nextionRxStats
+ *
+ */
+static void nextionHandleFrame(const uint8_t *frame)
+{
+  switch (frame[0])
+  {
+  case NEXTION_RET_OK:
+    nextionRxStats.acks++;
+    nextionAnswered();
+    break;
+
+  case NEXTION_RET_BUFFER_OVERFLOW:
+    nextionRxStats.overflows++;
+    nextionInflightCount = 0; // commands were lost, there's no telling which answers are still coming
+    break;
+
+  case NEXTION_RET_NUMBER:
+  case NEXTION_RET_STRING:
+    nextionAnswered(); // answer to a get
+    break;
+
+  case NEXTION_RET_TRANSPARENT_READY:
+    if (nextionTpState == NEXTION_TP_WAIT_READY)
+    {
+      nextionTpState = NEXTION_TP_SEND_DATA;
+    }
+    break;
+
+  case NEXTION_RET_TRANSPARENT_DONE:
+    if (nextionTpState == NEXTION_TP_WAIT_DONE)
+    {
+      nextionTpState = NEXTION_TP_IDLE;
+    }
+    break;
+
+  case NEXTION_RET_TOUCH:
+  case NEXTION_RET_PAGE:
+  case NEXTION_RET_SLEEP:
+  case NEXTION_RET_WAKE:
+  case NEXTION_RET_READY:
+    nextionRxStats.events++;
+    break;
+
+  default: // 0x00 - 0x23 are all command errors
+    nextionRxStats.errors++;
+    nextionRxStats.lastError = frame[0];
+    nextionAnswered();
+    break;
+  }
+}
+
+/**
+ * @brief Parses everything Serial1 has recieved so far, never waits for more, call every loop()
+ *
+ */
+void nextionRxPoll()
+{
+  while (Serial1.available() > 0)
+  {
+    uint8_t c = Serial1.read();
+    if (nextionRxLen == NEXTION_RX_MAX)
+    {
+      nextionRxStats.garbage += nextionRxLen; // never terminated, resync on the next byte
+      nextionRxLen = 0;
+      nextionRxTermCount = 0;
+    }
+    nextionRxBuf[nextionRxLen++] = c;
+    nextionRxTermCount = (c == NEXTION_TERMINATOR) ? nextionRxTermCount + 1 : 0;
+
+    bool complete = (nextionRxBuf[0] == NEXTION_RET_NUMBER) ? nextionRxLen == 8 : nextionRxTermCount == 3;
+    if (!complete)
+    {
+      continue;
+    }
+
+    if (nextionRxLen == 3)
+    {
+      nextionRxStats.garbage += 3; // bare terminator
+    }
+    else if (nextionRxTermCount >= 3)
+    {
+      nextionHandleFrame(nextionRxBuf);
+    }
+    else
+    {
+      nextionRxStats.garbage += nextionRxLen; // 0x71 without its terminator
+    }
+    nextionRxLen = 0;
+    nextionRxTermCount = 0;
+  }
+
+  while (nextionInflightCount > 0 && millis() - nextionInflight[nextionInflightHead] > NEXTION_ACK_TIMEOUT_MS)
+  {
+    nextionRxStats.timeouts++;
+    nextionInflightHead = (nextionInflightHead + 1) % NEXTION_INFLIGHT_MAX;
+    nextionInflightCount--;
+  }
+}
+
+/**
+ * @brief Formats and queues a command that takes no value
+ *
+ */
+void nextionSendRaw(const char *cmd)
+{
+  char buf[NEXTION_CMD_MAX];
+  nextionWrite(buf, nextionFormatRaw(buf, cmd));
+}
+
+/**
+ * @brief Formats and queues a numeric assignment (.val= or .pic=)
+ *
+ */
+void nextionSendInt(const char *prefix, int32_t val)
+{
+  char buf[NEXTION_CMD_MAX];
+  nextionWrite(buf, nextionFormatInt(buf, prefix, val));
+}
+
+/**
+ * @brief Formats and queues a fixed-point value to a text component
+ *
+ */
+void nextionSendFixedTxt(const char *prefix, int32_t val, uint8_t decimals)
+{
+  char buf[NEXTION_CMD_MAX];
+  nextionWrite(buf, nextionFormatFixedTxt(buf, prefix, val, decimals));
+}
+
+/**
+ * @brief Formats and queues a "m:ss" time to a text component
+ *
+ */
+void nextionSendTimeTxt(const char *prefix, uint32_t msec)
+{
+  char buf[NEXTION_CMD_MAX];
+  nextionWrite(buf, nextionFormatTimeTxt(buf, prefix, msec));
+}
+
+/**
+ * @brief Checks whether the LCD answers cleanly at a given rate, by sending "get dp" (the current page) and
+ * waiting for a well formed 0x71 numeric reply: 0x71, 4 value bytes, 0xFF 0xFF 0xFF
+ *
+ * @param baud rate to switch Serial1 to and test
+ * @return true if a complete reply arrived within NEXTION_REPLY_TIMEOUT_MS
+ */
+bool nextionProbe(uint32_t baud)
+{
+  Serial1.begin(baud);
+  Serial1.clear(); // drop anything recieved at the old rate
+  nextionSendRaw("get dp");
+  nextionTxDrain();
+
+  uint8_t matched = 0; // bytes of the reply matched so far
+  long unsigned int start = millis();
+  while (millis() - start < NEXTION_REPLY_TIMEOUT_MS)
+  {
+    if (Serial1.available() <= 0)
+    {
+      yield();
+      continue;
+    }
+
+    uint8_t c = Serial1.read();
+    if (matched == 0)
+    {
+      matched = (c == NEXTION_RET_NUMBER) ? 1 : 0;
+    }
+    else if (matched < 5)
+    {
+      matched++; // page number, any value
+    }
+    else if (c == NEXTION_TERMINATOR)
+    {
+      if (++matched == 8)
+      {
+        return true;
+      }
+    }
+    else
+    {
+      matched = (c == NEXTION_RET_NUMBER) ? 1 : 0; // garbled, start over
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Tells the LCD to switch rates (baud=, not saved on the LCD) while talking to it at another rate
+ *
+ * @param from rate the LCD is believed to be at
+ * @param to rate to switch the LCD to
+ */
+void nextionSetBaud(uint32_t from, uint32_t to)
+{
+  Serial1.begin(from);
+  nextionSendInt("baud=", to);
+  nextionTxDrain();
+  Serial1.flush(); // the command has to be fully out before Serial1 changes rate
+  delay(NEXTION_BAUD_SETTLE_MS);
+}
+
+/**
+ * @brief Brings the LCD link up at the fastest rate that gives clean replies
+ *
+ * @details If the LCD already answers at lastGood (e.g. only the Teensy was reset) that rate is kept. Otherwise
+ * the LCD is sent back to its power-on default from lastGood and has to answer there, then it's told to switch to
+ * each of nextionBaudRates in turn, fastest first, until a "get dp" comes back clean. A failed rate may have left
+ * the LCD at that rate with a bad link, so the next baud= is sent at both the last rate that worked and the rate
+ * that just failed. An LCD that answers at neither lastGood nor the default isn't there, so no sweep is tried.
+ *
+ * @param lastGood rate saved by the last successful negotiation, anything not in nextionBaudRates is ignored
+ * @return uint32_t the rate Serial1 and the LCD are left at, 0 if the LCD never answered (Serial1 is left at
+ * NEXTION_DEFAULT_BAUD)
+ */
+uint32_t nextionNegotiateBaud(uint32_t lastGood)
+{
+  bool lastGoodValid = false;
+  for (uint8_t i = 0; i < NEXTION_BAUD_RATE_COUNT; i++)
+  {
+    lastGoodValid |= (nextionBaudRates[i] == lastGood);
+  }
+
+  if (lastGoodValid && nextionProbe(lastGood))
+  {
+    return lastGood;
+  }
+
+  uint32_t linkRate = NEXTION_DEFAULT_BAUD;
+  if (lastGoodValid && lastGood != NEXTION_DEFAULT_BAUD)
+  {
+    nextionSetBaud(lastGood, NEXTION_DEFAULT_BAUD); // in case it's at lastGood with a bad link
+  }
+  if (!nextionProbe(NEXTION_DEFAULT_BAUD))
+  {
+    return 0; // unplugged or not powered, a sweep would only time out at every rate
+  }
+
+  uint32_t failedRate = 0;
+  for (uint8_t i = 0; i < NEXTION_BAUD_RATE_COUNT; i++)
+  {
+    uint32_t rate = nextionBaudRates[i];
+    nextionSetBaud(linkRate, rate);
+    if (failedRate != 0)
+    {
+      nextionSetBaud(failedRate, rate);
+    }
+
+    if (nextionProbe(rate))
+    {
+      return rate;
+    }
+    failedRate = rate;
+  }
+
+  Serial1.begin(NEXTION_DEFAULT_BAUD); // no clean reply anywhere, fall back to the rate the LCD powers up at
+  return NEXTION_DEFAULT_BAUD;
+}
+
+/**
+ * @brief Queues a batch of points for a waveform channel as one addt transfer instead of one add per point
+ *
+ * @param objId the waveform's component id
+ * @param channel waveform channel, 0-3
+ * @param data the points, 0 - waveform height
+ * @param qty number of points, at most NEXTION_ADDT_MAX
+ * @return true if the transfer was queued
+ */
+bool nextionSendAddt(uint8_t objId, uint8_t channel, const uint8_t *data, uint8_t qty)
+{
+  char buf[NEXTION_CMD_MAX];
+  return nextionWriteTransparent(buf, nextionFormatAddt(buf, objId, channel, qty), data, qty, NEXTION_KEY_NONE);
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test_main.cpp
+ * @brief FlexCAN acceptance filters: only IDs with a decoder wake the CPU, range filters never wake for extras, and
+ * every frame that gets through runs each of its handlers once
+ *
+ * pio test -e native -f test_can_filters
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
+uint8_t canFilterBlockEnd(const uint32_t *ids, uint8_t i, uint8_t idCount);
+void CANmsgRecieve(const CAN_message_t &msg);
+void rpmFastPathRecieve(const CAN_message_t &msg);
+void gearFastPathRecieve(const CAN_message_t &msg);
+uint32_t getCANInterruptRate();
+void setup();
+
+#ifndef CAN_FAST_PATH
+#define CAN_FAST_PATH 1             // as in canDispatch.h
+#endif
+#define FAST_PATH_MB_RPM MB8        // CAN_FAST_PATH_MB_RPM
+#define FAST_PATH_MB_GEAR MB9       // CAN_FAST_PATH_MB_GEAR
+
+const uint32_t decodedIDs[] = {0x640, 0x641, 0x642, 0x644, 0x648, 0x649, 0x64D}; // see initCANDispatch()
+
+static uint32_t mailboxRuns;
+static uint32_t globalRuns;
+
+static void countRPMMailbox(const CAN_message_t &msg)
+{
+  mailboxRuns++;
+  rpmFastPathRecieve(msg);
+}
+
+static void countGearMailbox(const CAN_message_t &msg)
+{
+  mailboxRuns++;
+  gearFastPathRecieve(msg);
+}
+
+static void countGlobal(const CAN_message_t &msg)
+{
+  globalRuns++;
+  CANmsgRecieve(msg);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_block_end_only_takes_aligned_blocks()
+{
+  const uint32_t ids[] = {0x641, 0x642, 0x643, 0x644, 0x645, 0x646, 0x647, 0x648, 0x64A};
+  TEST_ASSERT_EQUAL_UINT8(0, canFilterBlockEnd(ids, 0, 9)); // 0x641 is odd, alone
+  TEST_ASSERT_EQUAL_UINT8(2, canFilterBlockEnd(ids, 1, 9)); // 0x642-0x643
+  TEST_ASSERT_EQUAL_UINT8(6, canFilterBlockEnd(ids, 3, 9)); // 0x644-0x647
+  TEST_ASSERT_EQUAL_UINT8(7, canFilterBlockEnd(ids, 7, 9)); // 0x648, 0x649 isn't there
+  TEST_ASSERT_EQUAL_UINT8(8, canFilterBlockEnd(ids, 8, 9));
+
+  const uint32_t run[] = {0x640, 0x641, 0x642};
+  TEST_ASSERT_EQUAL_UINT8(1, canFilterBlockEnd(run, 0, 3)); // 0x640-0x643 would also take 0x643
+}
+
+void test_only_decoded_ids_wake_the_cpu()
+{
+  uint32_t wakeups = Can0.wakeups;
+  uint32_t filtered = Can0.filtered;
+
+  CAN_message_t msg;
+  for (uint32_t id = 0x600; id < 0x700; id++)
+  {
+    msg.id = id;
+    Can0.inject(msg);
+  }
+
+  uint32_t decoded = sizeof(decodedIDs) / sizeof(decodedIDs[0]);
+  TEST_ASSERT_EQUAL_UINT32(decoded, Can0.wakeups - wakeups);
+  TEST_ASSERT_EQUAL_UINT32(0x100 - decoded, Can0.filtered - filtered);
+}
+
+void test_each_decoded_id_gets_through()
+{
+  CAN_message_t msg;
+  for (uint32_t id : decodedIDs)
+  {
+    uint32_t wakeups = Can0.wakeups;
+    msg.id = id;
+    TEST_ASSERT_TRUE(Can0.inject(msg));
+    TEST_ASSERT_EQUAL_UINT32(wakeups + 1, Can0.wakeups);
+  }
+}
+
+void test_each_frame_runs_each_handler_once()
+{
+  Can0.onReceive(FAST_PATH_MB_RPM, countRPMMailbox);
+  Can0.onReceive(FAST_PATH_MB_GEAR, countGearMailbox);
+  Can0.onReceive(countGlobal);
+  mailboxRuns = 0;
+  globalRuns = 0;
+
+  nativeAdvanceMicros(1000);
+  getCANInterruptRate(); // starts the window
+  CAN_message_t msg;
+  for (int i = 0; i < 10; i++)
+  {
+    msg.id = 0x640;
+    Can0.inject(msg);
+    msg.id = 0x64D;
+    Can0.inject(msg);
+    nativeAdvanceMicros(100000);
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(CAN_FAST_PATH ? 20 : 0, mailboxRuns);
+  TEST_ASSERT_EQUAL_UINT32(20, globalRuns);
+  TEST_ASSERT_EQUAL_UINT32(20, getCANInterruptRate()); // each frame deposited once, 20 frames in 1s
+
+  Can0.onReceive(FAST_PATH_MB_RPM, rpmFastPathRecieve);
+  Can0.onReceive(FAST_PATH_MB_GEAR, gearFastPathRecieve);
+  Can0.onReceive(CANmsgRecieve);
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_block_end_only_takes_aligned_blocks);
+  RUN_TEST(test_only_decoded_ids_wake_the_cpu);
+  RUN_TEST(test_each_decoded_id_gets_through);
+  RUN_TEST(test_each_frame_runs_each_handler_once);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file test_main.cpp
+ * @brief Per-ID CAN counters: frames thinned out by a slot's minInterval count as dropped, frames overwritten
+ * before loop() got to the slot count as coalesced
+ *
+ * The counters are read back from printCANStats() on the USB serial port.
+ *
+ * pio test -e native -f test_can_stats
+ */
+
+#include <Arduino.h>
+#include <m150Signals.h>
+#include <unity.h>
+
+#include <string>
+
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
+void printCANStats();
+void setup();
+void loop();
+
+#define MIN_INTERVAL_MS 50          // throttle's minInterval in initCANDispatch()
+
+static std::string printed;         // everything written to Serial since the last readStat()
+
+static void capturePrint(const uint8_t *buf, size_t len)
+{
+  printed.append((const char *)buf, len);
+}
+
+/**
+ * @brief One of printCANStats()' counters for the throttle ID
+ *
+ * @param name the column, e.g. "DROPPED:"
+ */
+static uint32_t readStat(const char *name)
+{
+  printed.clear();
+  printCANStats();
+  size_t line = printed.find("ID   642");
+  size_t at = printed.find(name, line);
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, line);
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, at);
+  return strtoul(printed.c_str() + at + strlen(name), nullptr, 10);
+}
+
+static void sendThrottle(uint16_t raw)
+{
+  CAN_message_t msg;
+  msg.id = M150_ID_THROTTLE;
+  msg.buf[0] = raw >> 8;
+  msg.buf[1] = raw & 0xFF;
+  Can0.inject(msg);
+}
+
+void setUp()
+{
+  Serial.txHook = capturePrint;
+  nativeAdvanceMicros(MIN_INTERVAL_MS * 1000);
+  sendThrottle(100);
+  loop(); // decoded, starts a fresh minInterval
+}
+
+void tearDown()
+{
+  Serial.txHook = nullptr;
+}
+
+void test_frames_held_back_by_the_rate_limit_are_dropped()
+{
+  uint32_t dropped = readStat("DROPPED:");
+  uint32_t coalesced = readStat("COALESCED:");
+
+  for (int i = 0; i < 3; i++)
+  {
+    nativeAdvanceMicros(10000);
+    sendThrottle(200 + i);
+    loop(); // inside the minInterval, held
+  }
+  nativeAdvanceMicros(MIN_INTERVAL_MS * 1000);
+  loop();
+
+  TEST_ASSERT_EQUAL_UINT32(dropped + 2, readStat("DROPPED:")); // the newest of the 3 was decoded
+  TEST_ASSERT_EQUAL_UINT32(coalesced, readStat("COALESCED:"));
+}
+
+void test_frames_overwritten_before_loop_runs_are_coalesced()
+{
+  uint32_t dropped = readStat("DROPPED:");
+  uint32_t coalesced = readStat("COALESCED:");
+
+  nativeAdvanceMicros(MIN_INTERVAL_MS * 1000);
+  for (int i = 0; i < 3; i++)
+  {
+    sendThrottle(300 + i); // no loop() in between, as if it were stuck on the LCD
+  }
+  loop();
+
+  TEST_ASSERT_EQUAL_UINT32(coalesced + 2, readStat("COALESCED:"));
+  TEST_ASSERT_EQUAL_UINT32(dropped, readStat("DROPPED:"));
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_held_back_by_the_rate_limit_are_dropped);
+  RUN_TEST(test_frames_overwritten_before_loop_runs_are_coalesced);
+  return UNITY_END();
+}
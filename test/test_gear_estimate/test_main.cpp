@@ -0,0 +1,221 @@
+/**
+ * @file test_main.cpp
+ * @brief Gear estimator: midpoint classification, the hysteresis band, the dwell, the stop / low RPM paths and
+ * writing analogOutputPin only when the estimate changes
+ *
+ * Ratios are built from gearUpQ / gearDownQ: each pair sits GEAR_EST_HYST_PCT of the gap either side of the
+ * midpoint between two gears, so the midpoint, the gap and both gears' own ratios all follow from them.
+ *
+ * pio test -e native -f test_gear_estimate
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+extern uint32_t gearUpQ[5];
+extern uint32_t gearDownQ[5];
+extern uint8_t estGear;
+void initGearEstimator();
+uint8_t classifyGear(uint32_t ratioQ, uint8_t current);
+void estimateGear(int speedRaw, int rpm, uint32_t now);
+
+#define OUT_PIN A16                 // analogOutputPin
+#define OUT_STEP 42                 // GEAR_OUT_STEP
+#define DWELL_MS 150                // GEAR_EST_DWELL_MS
+#define MIN_RPM 1500                // GEAR_EST_MIN_RPM
+#define STOPPED 30                  // GEAR_EST_STOPPED
+#define RPM 6000
+#define NOT_WRITTEN 999             // put on the pin by the test, the estimator never writes it
+
+static uint32_t now;
+
+static uint32_t midQ(uint8_t i)     // between gear i + 1 and i + 2
+{
+  return (gearUpQ[i] + gearDownQ[i]) / 2;
+}
+
+static uint32_t gapQ(uint8_t i)
+{
+  return (gearUpQ[i] - gearDownQ[i]) * 100 / (2 * 25); // up - down is 2 * GEAR_EST_HYST_PCT of the gap
+}
+
+static uint32_t gearQ(uint8_t gear)
+{
+  return (gear < 6) ? midQ(gear - 1) - gapQ(gear - 1) / 2 : midQ(4) + gapQ(4) / 2;
+}
+
+/**
+ * @brief Wheelspeed (0.1 km/h) that gives ratioQ at RPM, rounded to the nearest
+ *
+ */
+static int speedFor(uint32_t ratioQ)
+{
+  return (int)(((uint64_t)ratioQ * RPM + 32768) >> 16);
+}
+
+static void feed(uint32_t ratioQ, uint32_t ms)
+{
+  estimateGear(speedFor(ratioQ), RPM, now);
+  now += ms;
+}
+
+/**
+ * @brief Holds ratioQ for one dwell and a frame, so any gear it means is output
+ *
+ */
+static void settle(uint32_t ratioQ)
+{
+  for (uint32_t t = 0; t <= DWELL_MS + 50; t += 50)
+  {
+    feed(ratioQ, 50);
+  }
+}
+
+void setUp()
+{
+  initGearEstimator();
+  now += 10000;
+}
+
+void tearDown() {}
+
+void test_each_gear_ratio_outputs_its_gear()
+{
+  for (uint8_t gear = 1; gear <= 6; gear++)
+  {
+    settle(gearQ(gear));
+    TEST_ASSERT_EQUAL_UINT8(gear, estGear);
+    TEST_ASSERT_EQUAL(gear * OUT_STEP, nativePinOutput(OUT_PIN));
+  }
+  for (uint8_t gear = 5; gear >= 1; gear--)
+  {
+    settle(gearQ(gear));
+    TEST_ASSERT_EQUAL_UINT8(gear, estGear);
+  }
+}
+
+void test_fresh_estimate_goes_by_the_midpoint()
+{
+  const uint8_t noGear[] = {0, 0xFF}; // neutral and GEAR_EST_UNKNOWN, no gear to hold
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    for (uint8_t current : noGear)
+    {
+      TEST_ASSERT_EQUAL_UINT8(i + 1, classifyGear(midQ(i) - gapQ(i) / 10, current));
+      TEST_ASSERT_EQUAL_UINT8(i + 2, classifyGear(midQ(i) + gapQ(i) / 10, current));
+    }
+  }
+
+  settle(midQ(2) + gapQ(2) / 10); // pulling away from a stop, 10 % past the 3rd / 4th midpoint
+  TEST_ASSERT_EQUAL_UINT8(4, estGear);
+}
+
+void test_hysteresis_band_holds_the_gear()
+{
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    uint8_t lower = i + 1;
+    uint8_t upper = i + 2;
+    TEST_ASSERT_EQUAL_UINT8(lower, classifyGear(gearUpQ[i] - 1, lower)); // still inside the band
+    TEST_ASSERT_EQUAL_UINT8(upper, classifyGear(gearUpQ[i], lower));
+    TEST_ASSERT_EQUAL_UINT8(upper, classifyGear(gearDownQ[i], upper));
+    TEST_ASSERT_EQUAL_UINT8(lower, classifyGear(gearDownQ[i] - 1, upper));
+  }
+
+  settle(gearQ(2));
+  settle(midQ(1) + gapQ(1) / 5); // 20 % past the midpoint, inside the 25 % band
+  TEST_ASSERT_EQUAL_UINT8(2, estGear);
+  settle(midQ(1) + gapQ(1) * 3 / 10);
+  TEST_ASSERT_EQUAL_UINT8(3, estGear);
+  settle(midQ(1) - gapQ(1) / 5);
+  TEST_ASSERT_EQUAL_UINT8(3, estGear);
+  settle(midQ(1) - gapQ(1) * 3 / 10);
+  TEST_ASSERT_EQUAL_UINT8(2, estGear);
+}
+
+void test_new_gear_has_to_hold_for_the_dwell()
+{
+  settle(gearQ(2));
+
+  feed(gearQ(3), DWELL_MS - 1);
+  feed(gearQ(3), 1);
+  TEST_ASSERT_EQUAL_UINT8(2, estGear);
+  TEST_ASSERT_EQUAL(2 * OUT_STEP, nativePinOutput(OUT_PIN));
+  feed(gearQ(3), 0); // DWELL_MS after it first showed up
+  TEST_ASSERT_EQUAL_UINT8(3, estGear);
+  TEST_ASSERT_EQUAL(3 * OUT_STEP, nativePinOutput(OUT_PIN));
+}
+
+void test_blip_or_slip_shorter_than_the_dwell_is_ignored()
+{
+  settle(gearQ(2));
+
+  feed(gearQ(3), 100);
+  feed(gearQ(2), 100); // back before the dwell, the candidate is dropped
+  feed(gearQ(3), 100);
+  TEST_ASSERT_EQUAL_UINT8(2, estGear);
+
+  feed(gearQ(3), 100);
+  feed(gearQ(6) * 2, 20); // clutch slip, no gear fits, restarts the dwell
+  feed(gearQ(3), 100);
+  feed(gearQ(3), 40);
+  TEST_ASSERT_EQUAL_UINT8(2, estGear);
+  feed(gearQ(3), 0); // 140 ms, still short
+  TEST_ASSERT_EQUAL_UINT8(2, estGear);
+  feed(gearQ(3), 10);
+  feed(gearQ(3), 0);
+  TEST_ASSERT_EQUAL_UINT8(3, estGear);
+}
+
+void test_stopped_is_neutral()
+{
+  settle(gearQ(4));
+
+  for (uint32_t t = 0; t <= DWELL_MS; t += 50)
+  {
+    estimateGear(STOPPED - 1, 900, now);
+    now += 50;
+  }
+  TEST_ASSERT_EQUAL_UINT8(0, estGear);
+  TEST_ASSERT_EQUAL(0, nativePinOutput(OUT_PIN));
+}
+
+void test_low_rpm_keeps_the_last_gear()
+{
+  settle(gearQ(4));
+
+  for (uint32_t t = 0; t <= 5 * DWELL_MS; t += 50)
+  {
+    estimateGear(400, MIN_RPM - 1, now); // rolling on the clutch, ratio would say 6th and beyond
+    now += 50;
+  }
+  TEST_ASSERT_EQUAL_UINT8(4, estGear);
+  TEST_ASSERT_EQUAL(4 * OUT_STEP, nativePinOutput(OUT_PIN));
+}
+
+void test_output_only_written_on_a_change()
+{
+  settle(gearQ(3));
+  analogWrite(OUT_PIN, NOT_WRITTEN);
+
+  settle(gearQ(3));
+  settle(midQ(2) + gapQ(2) / 5); // inside the band, still 3rd
+  TEST_ASSERT_EQUAL(NOT_WRITTEN, nativePinOutput(OUT_PIN));
+
+  settle(gearQ(4));
+  TEST_ASSERT_EQUAL(4 * OUT_STEP, nativePinOutput(OUT_PIN));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_each_gear_ratio_outputs_its_gear);
+  RUN_TEST(test_fresh_estimate_goes_by_the_midpoint);
+  RUN_TEST(test_hysteresis_band_holds_the_gear);
+  RUN_TEST(test_new_gear_has_to_hold_for_the_dwell);
+  RUN_TEST(test_blip_or_slip_shorter_than_the_dwell_is_ignored);
+  RUN_TEST(test_stopped_is_neutral);
+  RUN_TEST(test_low_rpm_keeps_the_last_gear);
+  RUN_TEST(test_output_only_written_on_a_change);
+  return UNITY_END();
+}
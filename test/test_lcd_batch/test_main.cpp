@@ -0,0 +1,92 @@
+/**
+ * @file test_main.cpp
+ * @brief ref_stop/ref_star frame batching only on links fast enough to afford the wrapper
+ *
+ * pio test -e native -f test_lcd_batch
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+
+enum Screen {Config1, Config2, DragMode, Params, BSPD_Trig, BSPD_Trip, Shift, SlowDown}; // as in NextionLCD.h
+
+extern long unsigned int lcdBaud;
+void chngScrn(Screen page);
+void chngParamVal(int paramCode, int val);
+void setup();
+void loop();
+
+#define FRAME_US 60000              // a little over 1 / LCD_FRAME_HZ
+
+static std::string sent;            // everything written to Serial1 since the last frame()
+
+static void captureTx(const uint8_t *buf, size_t len)
+{
+  sent.append((const char *)buf, len);
+}
+
+/**
+ * @brief Puts a new RPM into the next LCD frame and returns what that frame sent
+ *
+ */
+static std::string frame(int rpm)
+{
+  sent.clear();
+  chngParamVal(10, rpm);
+  nativeAdvanceMicros(FRAME_US);
+  loop();
+  return sent;
+}
+
+void setUp()
+{
+  chngScrn(Config1); // one of LCD_BATCH_SCREENS
+  nativeAdvanceMicros(FRAME_US);
+  loop();
+  Serial1.txHook = captureTx;
+}
+
+void tearDown()
+{
+  Serial1.txHook = nullptr;
+}
+
+void test_no_batching_at_9600()
+{
+  lcdBaud = 9600;
+  std::string out = frame(4000);
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, out.find("RPM.val=4000"));
+  TEST_ASSERT_EQUAL(std::string::npos, out.find("ref_stop"));
+  TEST_ASSERT_EQUAL(std::string::npos, out.find("ref_star"));
+}
+
+void test_batching_at_115200()
+{
+  lcdBaud = 115200;
+  std::string out = frame(5000);
+  size_t stop = out.find("ref_stop");
+  size_t rpm = out.find("RPM.val=5000");
+  size_t start = out.find("ref_star");
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, rpm);
+  TEST_ASSERT_TRUE(stop < rpm && rpm < start && start != std::string::npos);
+}
+
+void test_idle_frame_sends_nothing()
+{
+  lcdBaud = 115200;
+  frame(6000);
+  TEST_ASSERT_EQUAL_STRING("", frame(6000).c_str()); // suppressed by the cache, no empty ref_stop/ref_star
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_no_batching_at_9600);
+  RUN_TEST(test_batching_at_115200);
+  RUN_TEST(test_idle_frame_sends_nothing);
+  return UNITY_END();
+}
@@ -0,0 +1,191 @@
+/**
+ * @file test_main.cpp
+ * @brief LCD transmit queue backpressure at 9600 baud, and the page button ISR leaving the queue to loop()
+ *
+ * Serial1 is the shim's in-memory UART, which drains at the configured baud in virtual time. Its write() never
+ * blocks, it just overfills, so every chunk the queue hands it is checked against the room it had.
+ *
+ * pio test -e native -f test_lcd_queue
+ */
+
+#include <Arduino.h>
+#include <nextionCommand.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+enum Screen {Config1, Config2, DragMode, Params, BSPD_Trig, BSPD_Trip, Shift, SlowDown}; // as in NextionLCD.h
+
+extern Screen currScreen;
+extern volatile int8_t pgBtnRequest;
+void setup();
+void loop();
+
+#define PAGE_BTN_PIN A17            // pgBtnPin
+#define PAGE_BTN_GAP_US 400000      // longer than PAGE_BTN_DEBOUNCE_MS
+
+static std::vector<std::string> chunks; // one per Serial1.write()
+static bool overfilled;
+
+static void captureTx(const uint8_t *buf, size_t len)
+{
+  chunks.emplace_back((const char *)buf, len);
+  overfilled |= Serial1.txUsed > Serial1.txSize;
+}
+
+static bool wholeCommand(const std::string &chunk)
+{
+  return chunk.size() >= 3 && chunk.compare(chunk.size() - 3, 3, "\xFF\xFF\xFF") == 0;
+}
+
+static uint8_t queueNumbered(uint8_t count, uint8_t key = NEXTION_KEY_NONE)
+{
+  char cmd[NEXTION_CMD_MAX];
+  uint8_t queued = 0;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    queued += nextionWrite(cmd, nextionFormatInt(cmd, "RPM.val=", 10000 + i), key);
+  }
+  return queued;
+}
+
+static void pressPageButton()
+{
+  nativeAdvanceMicros(PAGE_BTN_GAP_US);
+  nativeSetPin(PAGE_BTN_PIN, 1023);
+  TEST_ASSERT_TRUE(nativeFireInterrupt(PAGE_BTN_PIN));
+  nativeSetPin(PAGE_BTN_PIN, 0);
+}
+
+void setUp()
+{
+  nextionTxClear();
+  Serial1.begin(9600);
+  Serial1.flush();
+  Serial1.txHook = captureTx;
+  chunks.clear();
+  overfilled = false;
+}
+
+void tearDown()
+{
+  Serial1.txHook = nullptr;
+}
+
+void test_write_never_blocks_and_drops_whole_commands()
+{
+  uint32_t dropped = nextionTxStats.dropped;
+  uint32_t start = micros();
+
+  uint8_t queued = queueNumbered(NEXTION_TX_DEPTH + 10);
+
+  TEST_ASSERT_EQUAL_UINT32(start, micros());
+  TEST_ASSERT_EQUAL_UINT8(NEXTION_TX_DEPTH, queued);
+  TEST_ASSERT_EQUAL_UINT32(dropped + 10, nextionTxStats.dropped);
+  TEST_ASSERT_EQUAL_UINT8(NEXTION_TX_DEPTH, nextionTxStats.highWater);
+  TEST_ASSERT_TRUE(chunks.empty()); // nothing goes to Serial1 until the pump runs
+}
+
+void test_pump_only_hands_over_what_fits()
+{
+  queueNumbered(NEXTION_TX_DEPTH);
+  uint32_t start = micros();
+
+  nextionTxPump();
+  TEST_ASSERT_EQUAL_UINT32(start, micros()); // the pump never waits for the UART
+  TEST_ASSERT_FALSE(overfilled);
+  TEST_ASSERT_GREATER_THAN_UINT8(0, nextionTxStats.depth); // 9600 baud can't take 32 commands at once
+
+  size_t handedOver = chunks.size();
+  nextionTxPump();
+  TEST_ASSERT_EQUAL(handedOver, chunks.size()); // no time passed, no room freed
+
+  while (nextionTxStats.depth > 0)
+  {
+    nativeAdvanceMicros(1000); // about a byte at 9600
+    nextionTxPump();
+    TEST_ASSERT_FALSE(overfilled);
+  }
+
+  TEST_ASSERT_EQUAL(NEXTION_TX_DEPTH, chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++)
+  {
+    TEST_ASSERT_TRUE(wholeCommand(chunks[i]));
+    TEST_ASSERT_EQUAL_STRING(("RPM.val=" + std::to_string(10000 + i) + "\xFF\xFF\xFF").c_str(), chunks[i].c_str());
+  }
+}
+
+void test_same_key_replaces_the_queued_command()
+{
+  uint32_t replaced = nextionTxStats.replaced;
+  queueNumbered(5, 10);
+
+  TEST_ASSERT_EQUAL_UINT8(1, nextionTxStats.depth);
+  TEST_ASSERT_EQUAL_UINT32(replaced + 4, nextionTxStats.replaced);
+
+  nextionTxPump();
+  TEST_ASSERT_EQUAL(1, chunks.size());
+  TEST_ASSERT_EQUAL_STRING("RPM.val=10004\xFF\xFF\xFF", chunks[0].c_str());
+}
+
+void test_full_queue_keeps_taking_keyed_replacements()
+{
+  queueNumbered(NEXTION_TX_DEPTH, 11); // all but the first replace one another
+  queueNumbered(NEXTION_TX_DEPTH);
+  TEST_ASSERT_TRUE(nextionTxFull(NEXTION_KEY_NONE));
+  TEST_ASSERT_FALSE(nextionTxFull(11));
+}
+
+void test_page_button_isr_only_latches_the_page()
+{
+  loop(); // settle whatever setup() left queued
+  Screen before = currScreen;
+  uint8_t depth = nextionTxStats.depth;
+  chunks.clear();
+
+  pressPageButton();
+  TEST_ASSERT_EQUAL(before, currScreen);
+  TEST_ASSERT_EQUAL_UINT8(depth, nextionTxStats.depth);
+  TEST_ASSERT_TRUE(chunks.empty());
+  TEST_ASSERT_GREATER_OR_EQUAL(0, pgBtnRequest);
+
+  loop();
+  TEST_ASSERT_NOT_EQUAL(before, currScreen);
+  TEST_ASSERT_EQUAL(-1, pgBtnRequest);
+  TEST_ASSERT_FALSE(chunks.empty());
+  TEST_ASSERT_EQUAL_STRING("page Config1\xFF\xFF\xFF", chunks[0].c_str()); // setup() opens on Params
+}
+
+void test_page_button_debounces_and_cycles()
+{
+  const Screen order[] = {Config2, DragMode, Params, Config1};
+  for (Screen next : order)
+  {
+    pressPageButton();
+    nativeSetPin(PAGE_BTN_PIN, 1023);
+    nativeFireInterrupt(PAGE_BTN_PIN); // still held, inside PAGE_BTN_DEBOUNCE_MS
+    nativeSetPin(PAGE_BTN_PIN, 0);
+    loop();
+    TEST_ASSERT_EQUAL(next, currScreen);
+  }
+
+  pressPageButton(); // two presses before loop() gets to them move on two pages
+  pressPageButton();
+  loop();
+  TEST_ASSERT_EQUAL(DragMode, currScreen);
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_write_never_blocks_and_drops_whole_commands);
+  RUN_TEST(test_pump_only_hands_over_what_fits);
+  RUN_TEST(test_same_key_replaces_the_queued_command);
+  RUN_TEST(test_full_queue_keeps_taking_keyed_replacements);
+  RUN_TEST(test_page_button_isr_only_latches_the_page);
+  RUN_TEST(test_page_button_debounces_and_cycles);
+  return UNITY_END();
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test_main.cpp
+ * @brief Lambda / throttle trace: with -D LCD_TRACE drawn on the waveform on its page, never written as text there;
+ * without it DragMode keeps the text and nothing goes to the waveform
+ *
+ * pio test -e native -f test_lcd_trace, and again with -D LCD_TRACE added to build_flags
+ */
+
+#include <Arduino.h>
+#include <m150Signals.h>
+#include <unity.h>
+
+#include <string>
+
+enum Screen {Config1, Config2, DragMode, Params, BSPD_Trig, BSPD_Trip, Shift, SlowDown}; // as in NextionLCD.h
+
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
+extern uint32_t traceHead;
+void chngScrn(Screen page);
+void setup();
+void loop();
+
+#define STEP_US 60000               // longer than the lambda / throttle rate limits and an LCD frame
+
+static std::string sent;            // everything written to Serial1 since the last showScreen()
+
+static void captureTx(const uint8_t *buf, size_t len)
+{
+  sent.append((const char *)buf, len);
+}
+
+/**
+ * @brief Sends lambda and throttle frames for ms milliseconds, running loop() after each
+ *
+ */
+static void drive(uint32_t ms, uint16_t lambda, uint16_t throttle)
+{
+  for (uint32_t t = 0; t < ms * 1000; t += STEP_US)
+  {
+    CAN_message_t msg;
+    msg.id = M150_ID_FUEL;
+    msg.buf[2] = lambda >> 8;
+    msg.buf[3] = lambda & 0xFF;
+    msg.buf[4] = 0x10; // fuel pressure well above the warning
+    Can0.inject(msg);
+
+    msg.id = M150_ID_THROTTLE;
+    msg.buf[0] = throttle >> 8;
+    msg.buf[1] = throttle & 0xFF;
+    Can0.inject(msg);
+
+    nativeAdvanceMicros(STEP_US);
+    loop();
+    lambda++;
+    throttle += 10;
+  }
+}
+
+static void showScreen(Screen page)
+{
+  chngScrn(page);
+  nativeAdvanceMicros(STEP_US);
+  loop();
+  sent.clear();
+}
+
+void setUp()
+{
+  Serial1.txHook = captureTx;
+}
+
+void tearDown()
+{
+  Serial1.txHook = nullptr;
+}
+
+#ifdef LCD_TRACE
+void test_trace_page_gets_no_lambda_or_throttle_text()
+{
+  showScreen(DragMode);
+  uint32_t head = traceHead;
+
+  drive(2000, 95, 200);
+
+  TEST_ASSERT_GREATER_THAN_UINT32(head, traceHead); // still sampled
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, sent.find("addt 20,0,")); // TRACE_WAVEFORM_ID, channel 0
+  TEST_ASSERT_EQUAL(std::string::npos, sent.find("Lam.txt="));
+  TEST_ASSERT_EQUAL(std::string::npos, sent.find("Thrt.txt="));
+}
+#else
+void test_drag_mode_unchanged_without_the_trace()
+{
+  showScreen(DragMode);
+  uint32_t head = traceHead;
+
+  drive(2000, 95, 200);
+
+  TEST_ASSERT_EQUAL_UINT32(head, traceHead); // nothing sampled
+  TEST_ASSERT_EQUAL(std::string::npos, sent.find("addt "));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, sent.find("Lam.txt="));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, sent.find("Thrt.txt="));
+}
+#endif
+
+void test_other_pages_still_get_the_text()
+{
+  showScreen(Config1);
+
+  drive(500, 95, 200);
+
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, sent.find("Lam.txt="));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, sent.find("Thrt.txt="));
+  TEST_ASSERT_EQUAL(std::string::npos, sent.find("addt "));
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+#ifdef LCD_TRACE
+  RUN_TEST(test_trace_page_gets_no_lambda_or_throttle_text);
+#else
+  RUN_TEST(test_drag_mode_unchanged_without_the_trace);
+#endif
+  RUN_TEST(test_other_pages_still_get_the_text);
+  return UNITY_END();
+}
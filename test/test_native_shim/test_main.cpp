@@ -0,0 +1,195 @@
+/**
+ * @file test_main.cpp
+ * @brief [env:native] shim: virtual time, IntervalTimer and the Serial1 TX drain the other suites rely on
+ *
+ * pio test -e native -f test_native_shim
+ */
+
+#include <Arduino.h>
+#include <nextionCommand.h>
+#include <unity.h>
+
+#include <string>
+
+static IntervalTimer testTimer;
+static FlexCAN_T4<CAN2, RX_SIZE_256, TX_SIZE_16> testCAN;
+static uint32_t timerCalls;
+static uint32_t timerCalledAt[4];
+static std::string handlersRun;     // one letter per onReceive() handler, in the order they ran
+
+static void countTimer()
+{
+  if (timerCalls < 4)
+  {
+    timerCalledAt[timerCalls] = micros();
+  }
+  timerCalls++;
+}
+
+static void recordMailbox(const CAN_message_t &msg)
+{
+  handlersRun += 'm';
+}
+
+static void recordFIFO(const CAN_message_t &msg)
+{
+  handlersRun += 'f';
+}
+
+static void recordGlobal(const CAN_message_t &msg)
+{
+  handlersRun += 'g';
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_time_only_moves_when_asked()
+{
+  uint32_t start = micros();
+  Serial1.begin(9600);
+  for (int i = 0; i < 1000; i++)
+  {
+    TEST_ASSERT_EQUAL(0, Serial1.available()); // polling an empty port costs no virtual time
+  }
+  TEST_ASSERT_EQUAL_UINT32(start, micros());
+
+  nativeAdvanceMicros(1500);
+  TEST_ASSERT_EQUAL_UINT32(start + 1500, micros());
+  delay(2);
+  TEST_ASSERT_EQUAL_UINT32(start + 3500, micros());
+  yield();
+  TEST_ASSERT_EQUAL_UINT32(start + 3501, micros());
+}
+
+void test_interval_timer_fires_on_its_period()
+{
+  timerCalls = 0;
+  uint32_t start = micros();
+  TEST_ASSERT_TRUE(testTimer.begin(countTimer, 1000));
+  nativeAdvanceMicros(3500);
+  testTimer.end();
+  nativeAdvanceMicros(5000);
+
+  TEST_ASSERT_EQUAL_UINT32(3, timerCalls);
+  TEST_ASSERT_EQUAL_UINT32(start + 1000, timerCalledAt[0]); // each call sees the time it was due at
+  TEST_ASSERT_EQUAL_UINT32(start + 2000, timerCalledAt[1]);
+  TEST_ASSERT_EQUAL_UINT32(start + 3000, timerCalledAt[2]);
+}
+
+void test_serial_tx_drains_at_the_baud_rate()
+{
+  uint8_t buf[64];
+  memset(buf, 'x', sizeof(buf));
+  Serial1.begin(9600);
+  int room = Serial1.availableForWrite();
+  Serial1.write(buf, room);
+  TEST_ASSERT_EQUAL(0, Serial1.availableForWrite());
+
+  nativeAdvanceMicros((10 * 10 * 1000000UL + 9599) / 9600); // 10 bytes at 10 bits each, rounded up
+  TEST_ASSERT_EQUAL(10, Serial1.availableForWrite());
+
+  Serial1.flush(); // blocks in virtual time until the rest is out
+  TEST_ASSERT_EQUAL(room, Serial1.availableForWrite());
+}
+
+void test_probe_times_out_without_an_lcd()
+{
+  uint32_t start = millis();
+  TEST_ASSERT_FALSE(nextionProbe(115200)); // the wait yield()s, so it ends instead of spinning forever
+  uint32_t took = millis() - start;
+  TEST_ASSERT_UINT32_WITHIN(2, NEXTION_REPLY_TIMEOUT_MS, took);
+}
+
+void test_negotiation_gives_up_without_an_lcd()
+{
+  uint32_t start = millis();
+  TEST_ASSERT_EQUAL_UINT32(0, nextionNegotiateBaud(115200));
+  uint32_t took = millis() - start;
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(2 * NEXTION_REPLY_TIMEOUT_MS + NEXTION_BAUD_SETTLE_MS + 10, took); // no sweep
+}
+
+void test_can_inject_honours_fifo_filters()
+{
+  CAN_message_t msg;
+  testCAN.begin();
+  testCAN.enableFIFO();
+  testCAN.setRFFN(RFFN_8);
+  testCAN.setFIFOFilter(REJECT_ALL);
+  testCAN.setFIFOFilter(0, 0x640, STD);
+
+  msg.id = 0x640;
+  TEST_ASSERT_TRUE(testCAN.inject(msg));
+  msg.id = 0x641;
+  TEST_ASSERT_FALSE(testCAN.inject(msg));
+  TEST_ASSERT_EQUAL_UINT32(1, testCAN.filtered);
+}
+
+void test_can_inject_runs_its_own_then_the_global_handler()
+{
+  CAN_message_t msg;
+  testCAN.begin();
+  testCAN.enableFIFO();
+  testCAN.setRFFN(RFFN_8);
+  testCAN.setFIFOFilter(REJECT_ALL);
+  testCAN.setFIFOFilter(0, 0x641, STD);
+  testCAN.onReceive(FIFO, recordFIFO);
+  testCAN.enableFIFOInterrupt();
+  testCAN.setMB(MB12, RX, STD);
+  testCAN.setMBFilter(MB12, 0x640);
+  testCAN.onReceive(MB12, recordMailbox);
+  testCAN.enableMBInterrupt(MB12);
+  testCAN.onReceive(recordGlobal);
+
+  handlersRun.clear();
+  msg.id = 0x640;
+  testCAN.inject(msg);
+  TEST_ASSERT_EQUAL_STRING("mg", handlersRun.c_str()); // like FlexCAN_T4's mbCallbacks(), both run once
+
+  handlersRun.clear();
+  msg.id = 0x641;
+  testCAN.inject(msg);
+  TEST_ASSERT_EQUAL_STRING("fg", handlersRun.c_str());
+
+  testCAN.onReceive(nullptr);
+  testCAN.onReceive(FIFO, nullptr);
+  testCAN.onReceive(MB12, nullptr);
+}
+
+void test_two_id_fifo_filter_wakes_for_its_mask()
+{
+  CAN_message_t msg;
+  testCAN.begin();
+  testCAN.enableFIFO();
+  testCAN.enableFIFOInterrupt();
+  testCAN.onReceive(recordGlobal);
+  testCAN.setRFFN(RFFN_8);
+  testCAN.setFIFOFilter(REJECT_ALL);
+  testCAN.setFIFOFilter(0, 0x641, 0x642, STD); // mask leaves out bits 0 and 1
+
+  uint32_t wakeups = testCAN.wakeups;
+  handlersRun.clear();
+  for (uint32_t id = 0x63C; id < 0x648; id++)
+  {
+    msg.id = id;
+    testCAN.inject(msg);
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, testCAN.wakeups - wakeups);  // 0x640-0x643
+  TEST_ASSERT_EQUAL_STRING("gg", handlersRun.c_str());     // only the two IDs get past the ISR's own check
+
+  testCAN.onReceive(nullptr);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_time_only_moves_when_asked);
+  RUN_TEST(test_interval_timer_fires_on_its_period);
+  RUN_TEST(test_serial_tx_drains_at_the_baud_rate);
+  RUN_TEST(test_probe_times_out_without_an_lcd);
+  RUN_TEST(test_negotiation_gives_up_without_an_lcd);
+  RUN_TEST(test_can_inject_honours_fifo_filters);
+  RUN_TEST(test_can_inject_runs_its_own_then_the_global_handler);
+  RUN_TEST(test_two_id_fifo_filter_wakes_for_its_mask);
+  return UNITY_END();
+}
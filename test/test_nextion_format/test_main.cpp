@@ -0,0 +1,169 @@
+/**
+ * @file test_main.cpp
+ * @brief Fixed-buffer Nextion formatters against what the String based code before them put on Serial1
+ *
+ * The baseline* functions below are the old chngParamVal() / convMSec_to_TForm() expressions with Arduino's String
+ * swapped for std::string. String(double) is Teensyduino's dtostrf(val, 4, 2), which is what "%4.2f" prints.
+ * Each command went out as Serial1.print(...) followed by endCommand()'s three 0xFF writes.
+ *
+ * pio test -e native -f test_nextion_format
+ */
+
+#include <Arduino.h>
+#include <nextionCommand.h>
+#include <unity.h>
+
+#include <string>
+
+static const std::string baselineEnd = "\xFF\xFF\xFF";
+
+static std::string baselineString(double val)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%4.2f", val);
+  return buf;
+}
+
+static std::string baselineString(int val)
+{
+  return std::to_string(val);
+}
+
+/**
+ * @brief convMSec_to_TForm() as it was, including the holder -= secs slip, which never changes the minutes
+ *
+ */
+static std::string baselineTime(long unsigned int val)
+{
+  long unsigned int holder = val;
+  int secs = (holder % 60000) / 1000;
+  holder -= secs;
+  int mins = (holder == 0) ? 0 : holder / 60000;
+
+  std::string build = baselineString(mins) + ":";
+  build += (secs < 10) ? "0" + baselineString(secs) : baselineString(secs);
+  return build;
+}
+
+static std::string baselineFloatTxt(const char *component, double val)
+{
+  return std::string(component) + ".txt=\"" + baselineString(val) + "\"" + baselineEnd;
+}
+
+static std::string baselineTimeTxt(const char *component, long unsigned int msec)
+{
+  return std::string(component) + ".txt=\"" + baselineTime(msec) + "\"" + baselineEnd;
+}
+
+static void assertSameBytes(const std::string &expected, const char *buf, uint8_t len)
+{
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.size(), len, expected.c_str());
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected.data(), buf, len, expected.c_str());
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_batt_matches_baseline()
+{
+  char buf[NEXTION_CMD_MAX];
+  for (int32_t hundredths = 0; hundredths <= 1600; hundredths++) // 0-16 V
+  {
+    uint8_t len = nextionFormatFixedTxt(buf, "Batt.txt=", hundredths, 2);
+    assertSameBytes(baselineFloatTxt("Batt", hundredths / 100.0), buf, len);
+  }
+  assertSameBytes("Batt.txt=\"13.80\"\xFF\xFF\xFF", buf, nextionFormatFixedTxt(buf, "Batt.txt=", 1380, 2));
+}
+
+void test_lambda_matches_baseline()
+{
+  char buf[NEXTION_CMD_MAX];
+  for (int32_t hundredths = -200; hundredths <= 2000; hundredths++) // includes a bad negative reading
+  {
+    uint8_t len = nextionFormatFixedTxt(buf, "Lam.txt=", hundredths, 2);
+    assertSameBytes(baselineFloatTxt("Lam", hundredths / 100.0), buf, len);
+  }
+  assertSameBytes("Lam.txt=\"0.98\"\xFF\xFF\xFF", buf, nextionFormatFixedTxt(buf, "Lam.txt=", 98, 2));
+  assertSameBytes("Lam.txt=\"-0.05\"\xFF\xFF\xFF", buf, nextionFormatFixedTxt(buf, "Lam.txt=", -5, 2));
+}
+
+void test_throttle_matches_baseline()
+{
+  char buf[NEXTION_CMD_MAX];
+  for (int32_t hundredths = 0; hundredths <= 10000; hundredths++) // 0-100 %
+  {
+    uint8_t len = nextionFormatFixedTxt(buf, "Thrt.txt=", hundredths, 2);
+    assertSameBytes(baselineFloatTxt("Thrt", hundredths / 100.0), buf, len);
+  }
+  assertSameBytes("Thrt.txt=\"100.00\"\xFF\xFF\xFF", buf, nextionFormatFixedTxt(buf, "Thrt.txt=", 10000, 2));
+}
+
+void test_time_matches_baseline()
+{
+  const char *timers[] = {"timer_Delta", "timer_R1", "timer_R2", "timer_R3"};
+  char buf[NEXTION_CMD_MAX];
+  char prefix[20];
+  for (const char *timer : timers)
+  {
+    snprintf(prefix, sizeof(prefix), "%s.txt=", timer);
+    for (uint32_t msec = 0; msec < 62 * 60000; msec += 250) // past an hour, minutes don't wrap
+    {
+      uint8_t len = nextionFormatTimeTxt(buf, prefix, msec);
+      assertSameBytes(baselineTimeTxt(timer, msec), buf, len);
+    }
+  }
+  assertSameBytes("timer_R1.txt=\"0:00\"\xFF\xFF\xFF", buf, nextionFormatTimeTxt(buf, "timer_R1.txt=", 0));
+  assertSameBytes("timer_R1.txt=\"1:05\"\xFF\xFF\xFF", buf, nextionFormatTimeTxt(buf, "timer_R1.txt=", 65999));
+  assertSameBytes("timer_R1.txt=\"60:00\"\xFF\xFF\xFF", buf, nextionFormatTimeTxt(buf, "timer_R1.txt=", 3600000));
+}
+
+void test_pic_matches_baseline()
+{
+  struct
+  {
+    const char *prefix;
+    int pic;
+  } pics[] = {
+      {"pic_Delta.pic=", 6}, {"pic_Delta.pic=", 7},
+      {"WARN_ECTO.pic=", 1}, {"WARN_ECTO.pic=", 4},
+      {"WARN_FPRSR.pic=", 2}, {"WARN_FPRSR.pic=", 4},
+      {"WARN_OTEMP.pic=", 3}, {"WARN_OTEMP.pic=", 4},
+      {"WARN_OPRSR.pic=", 10}, {"WARN_OPRSR.pic=", 4},
+  };
+  char buf[NEXTION_CMD_MAX];
+  for (const auto &p : pics)
+  {
+    std::string expected = std::string(p.prefix) + baselineString(p.pic) + baselineEnd; // Serial1.print("WARN_ECTO.pic=1")
+    assertSameBytes(expected, buf, nextionFormatInt(buf, p.prefix, p.pic));
+  }
+}
+
+void test_val_matches_baseline()
+{
+  char buf[NEXTION_CMD_MAX];
+  const int32_t vals[] = {0, 7, -40, 9500, 13600, -2147483647 - 1, 2147483647};
+  for (int32_t val : vals)
+  {
+    std::string expected = "RPM.val=" + baselineString((int)val) + baselineEnd;
+    assertSameBytes(expected, buf, nextionFormatInt(buf, "RPM.val=", val));
+  }
+}
+
+void test_page_matches_baseline()
+{
+  char buf[NEXTION_CMD_MAX];
+  assertSameBytes("page Params\xFF\xFF\xFF", buf, nextionFormatRaw(buf, "page Params"));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_batt_matches_baseline);
+  RUN_TEST(test_lambda_matches_baseline);
+  RUN_TEST(test_throttle_matches_baseline);
+  RUN_TEST(test_time_matches_baseline);
+  RUN_TEST(test_pic_matches_baseline);
+  RUN_TEST(test_val_matches_baseline);
+  RUN_TEST(test_page_matches_baseline);
+  return UNITY_END();
+}
@@ -0,0 +1,129 @@
+/**
+ * @file test_main.cpp
+ * @brief LCD value cache: what writeParam() sends and what paramSuppressed() holds back
+ *
+ * pio test -e native -f test_param_cache
+ */
+
+#include <Arduino.h>
+#include <nextionCommand.h>
+#include <unity.h>
+
+void setup();
+void invalidateParamCache();
+bool paramSuppressed(int paramCode, int32_t val, const char *cmd, uint8_t len);
+bool writeParam(int paramCode, int32_t val, const char *cmd, uint8_t len, uint16_t &budget);
+
+#define RPM_PARAM 10                // deadband 50, hysteresis 50
+#define BATT_PARAM 0                // deadband 5, hysteresis 5
+#define GEAR_PARAM 6                // no deadband
+
+/**
+ * @brief Formats val for paramCode's component and hands it to writeParam() with plenty of budget
+ *
+ * @return true if the command went out, false if the cache suppressed it
+ */
+static bool send(int paramCode, const char *prefix, int32_t val)
+{
+  char cmd[NEXTION_CMD_MAX];
+  uint8_t len = nextionFormatInt(cmd, prefix, val);
+  bool suppressed = paramSuppressed(paramCode, val, cmd, len);
+  uint16_t budget = 1000;
+  TEST_ASSERT_TRUE(writeParam(paramCode, val, cmd, len, budget));
+  TEST_ASSERT_EQUAL_UINT16(suppressed ? 1000 : 1000 - len, budget);
+  return !suppressed;
+}
+
+static bool sendRPM(int32_t rpm)
+{
+  return send(RPM_PARAM, "RPM.val=", rpm);
+}
+
+void setUp()
+{
+  invalidateParamCache();
+  nextionTxClear();
+}
+
+void tearDown() {}
+
+void test_first_write_always_goes_out()
+{
+  TEST_ASSERT_TRUE(sendRPM(3000));
+  TEST_ASSERT_TRUE(send(GEAR_PARAM, "GEAR.val=", 0));
+}
+
+void test_same_bytes_are_suppressed()
+{
+  TEST_ASSERT_TRUE(send(GEAR_PARAM, "GEAR.val=", 3));
+  TEST_ASSERT_FALSE(send(GEAR_PARAM, "GEAR.val=", 3));
+  TEST_ASSERT_TRUE(send(GEAR_PARAM, "GEAR.val=", 4));
+}
+
+void test_same_value_rendered_differently_is_written()
+{
+  char cmd[NEXTION_CMD_MAX];
+  uint16_t budget = 1000;
+  uint8_t len = nextionFormatFixedTxt(cmd, "Batt.txt=", 1250, 2);
+  TEST_ASSERT_TRUE(writeParam(BATT_PARAM, 1250, cmd, len, budget));
+
+  len = nextionFormatFixedTxt(cmd, "Batt.txt=", 1250, 1); // "125.0", not what's on screen
+  TEST_ASSERT_FALSE(paramSuppressed(BATT_PARAM, 1250, cmd, len));
+}
+
+void test_rpm_deadband()
+{
+  TEST_ASSERT_TRUE(sendRPM(3000));
+  TEST_ASSERT_FALSE(sendRPM(3049));
+  TEST_ASSERT_TRUE(sendRPM(3050));
+  TEST_ASSERT_FALSE(sendRPM(3001)); // 49 below what's on screen
+}
+
+void test_reversal_needs_deadband_plus_hysteresis()
+{
+  TEST_ASSERT_TRUE(sendRPM(3000));
+  TEST_ASSERT_TRUE(sendRPM(3100));  // rising
+  TEST_ASSERT_FALSE(sendRPM(3020)); // falling back 80, under 50 + 50
+  TEST_ASSERT_TRUE(sendRPM(3000));
+  TEST_ASSERT_TRUE(sendRPM(2950));  // still falling, deadband only
+}
+
+void test_drop_to_zero_is_always_written()
+{
+  TEST_ASSERT_TRUE(sendRPM(800));
+  TEST_ASSERT_FALSE(sendRPM(780));
+  TEST_ASSERT_TRUE(sendRPM(30)); // stalling
+  TEST_ASSERT_TRUE(sendRPM(0));  // 30 is inside the deadband, but the stop has to show
+  TEST_ASSERT_FALSE(sendRPM(0));
+}
+
+void test_drop_to_zero_after_a_rise()
+{
+  TEST_ASSERT_TRUE(send(BATT_PARAM, "Batt.val=", 1));
+  TEST_ASSERT_TRUE(send(BATT_PARAM, "Batt.val=", 6));
+  TEST_ASSERT_TRUE(send(BATT_PARAM, "Batt.val=", 0)); // reversal wants 10, 0 goes out anyway
+}
+
+void test_page_change_forgets_what_was_sent()
+{
+  TEST_ASSERT_TRUE(sendRPM(3000));
+  TEST_ASSERT_FALSE(sendRPM(3000));
+  invalidateParamCache();
+  TEST_ASSERT_TRUE(sendRPM(3000));
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_first_write_always_goes_out);
+  RUN_TEST(test_same_bytes_are_suppressed);
+  RUN_TEST(test_same_value_rendered_differently_is_written);
+  RUN_TEST(test_rpm_deadband);
+  RUN_TEST(test_reversal_needs_deadband_plus_hysteresis);
+  RUN_TEST(test_drop_to_zero_is_always_written);
+  RUN_TEST(test_drop_to_zero_after_a_rise);
+  RUN_TEST(test_page_change_forgets_what_was_sent);
+  return UNITY_END();
+}
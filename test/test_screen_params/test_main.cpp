@@ -0,0 +1,151 @@
+/**
+ * @file test_main.cpp
+ * @brief Screen subscriptions: every channel is decoded on every screen, screenParams only picks what the LCD is sent,
+ * and a page change replays the latest of everything the new page shows
+ *
+ * pio test -e native -f test_screen_params
+ */
+
+#include <Arduino.h>
+#include <m150Signals.h>
+#include <unity.h>
+
+#include <string>
+
+enum Screen {Config1, Config2, DragMode, Params, BSPD_Trig, BSPD_Trip, Shift, SlowDown}; // as in NextionLCD.h
+
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
+extern Screen currScreen;
+extern int currBatt, currLamb, currMAP, currThrtl, maxWSpd;
+void chngScrn(Screen page);
+void setup();
+void loop();
+
+#define STEP_US 200000              // longer than any CAN rate limit or LCD frame
+
+static std::string sent;            // everything written to Serial1 since setUp()
+
+static void captureTx(const uint8_t *buf, size_t len)
+{
+  sent.append((const char *)buf, len);
+}
+
+static void send16(uint32_t id, uint8_t byte, uint16_t raw)
+{
+  CAN_message_t msg;
+  msg.id = id;
+  msg.buf[byte] = raw >> 8;
+  msg.buf[byte + 1] = raw & 0xFF;
+  nativeAdvanceMicros(STEP_US);
+  Can0.inject(msg);
+  loop();
+}
+
+static void sendBattery(uint8_t raw)
+{
+  CAN_message_t msg;
+  msg.id = M150_ID_TEMPS;
+  msg.buf[0] = 40 + 80; // 80 C coolant, nowhere near the warning
+  msg.buf[1] = 40 + 90;
+  msg.buf[5] = raw;
+  nativeAdvanceMicros(STEP_US);
+  Can0.inject(msg);
+  loop();
+}
+
+static void showScreen(Screen page)
+{
+  chngScrn(page);
+  nativeAdvanceMicros(STEP_US);
+  loop();
+  sent.clear();
+}
+
+void setUp()
+{
+  Serial1.txHook = captureTx;
+  sent.clear();
+}
+
+void tearDown()
+{
+  Serial1.txHook = nullptr;
+}
+
+void test_wheelspeed_peak_is_kept_off_screen()
+{
+  showScreen(Config1); // MaxWS isn't on it
+  maxWSpd = 0;
+
+  send16(M150_ID_WHEELSPEED, 6, 500);
+  send16(M150_ID_WHEELSPEED, 6, 1500);
+  send16(M150_ID_WHEELSPEED, 6, 800);
+
+  uint8_t peak[8] = {0, 0, 0, 0, 0, 0, 1500 >> 8, 1500 & 0xFF};
+  TEST_ASSERT_EQUAL(M150_WheelSpeed::value(peak), maxWSpd);
+  TEST_ASSERT_EQUAL(std::string::npos, sent.find("MaxWS.val="));
+}
+
+void test_params_channels_decoded_on_config1()
+{
+  showScreen(Config1);
+
+  send16(M150_ID_ENGINE, 2, 980);   // 98.0 kPa
+  send16(M150_ID_FUEL, 2, 97);      // 0.97 lambda
+  send16(M150_ID_THROTTLE, 0, 455); // 45.5 %
+  sendBattery(138);                 // 13.8 V
+
+  TEST_ASSERT_EQUAL(98, currMAP);
+  TEST_ASSERT_EQUAL(97, currLamb);
+  TEST_ASSERT_EQUAL(4550, currThrtl);
+  TEST_ASSERT_EQUAL(1380, currBatt);
+
+  TEST_ASSERT_EQUAL(std::string::npos, sent.find("Map.val="));               // Params only, no bytes for it
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, sent.find("Batt.txt=\"13.80\"")); // on every screen
+}
+
+void test_entering_params_replays_what_changed_off_screen()
+{
+  showScreen(Params);
+  send16(M150_ID_ENGINE, 2, 500);   // 50 kPa shown on Params
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, sent.find("Map.val=50\xFF\xFF\xFF"));
+
+  showScreen(Config1);
+  send16(M150_ID_ENGINE, 2, 1010);  // 101 kPa, not sent while Config1 is up
+  send16(M150_ID_WHEELSPEED, 6, 2000);
+  send16(M150_ID_FUEL, 2, 102);
+  TEST_ASSERT_EQUAL(std::string::npos, sent.find("Map.val="));
+
+  sent.clear();
+  chngScrn(Params);
+  loop(); // no new frames, only the replay
+
+  size_t page = sent.find("page Params");
+  size_t stop = sent.find("ref_stop");
+  size_t start = sent.find("ref_star");
+  TEST_ASSERT_EQUAL(0, page);
+  TEST_ASSERT_TRUE(page < stop && stop < start);
+
+  const char *replayed[] = {"Map.val=101\xFF\xFF\xFF", "Lam.txt=\"1.02\"\xFF\xFF\xFF", "Batt.txt=\"13.80\"\xFF\xFF\xFF"};
+  for (const char *cmd : replayed)
+  {
+    size_t at = sent.find(cmd);
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(std::string::npos, at, cmd);
+    TEST_ASSERT_TRUE_MESSAGE(stop < at && at < start, cmd); // inside the one burst
+  }
+  char maxWS[24];
+  snprintf(maxWS, sizeof(maxWS), "MaxWS.val=%d\xFF\xFF\xFF", maxWSpd);
+  size_t at = sent.find(maxWS);
+  TEST_ASSERT_TRUE(stop < at && at < start);
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_wheelspeed_peak_is_kept_off_screen);
+  RUN_TEST(test_params_channels_decoded_on_config1);
+  RUN_TEST(test_entering_params_replays_what_changed_off_screen);
+  return UNITY_END();
+}
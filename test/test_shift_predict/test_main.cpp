@@ -0,0 +1,186 @@
+/**
+ * @file test_main.cpp
+ * @brief Predictive shift light: replays fixed RPM ramps per gear and checks when the light fires
+ *
+ * RPM and gear go in as 0x640 / 0x64D frames through Can0.inject(), 10ms apart like the M150 sends them, each
+ * followed by a loop(), so the fast path mailbox ISR, the history and the fit in loop() all run as on the car.
+ *
+ * pio test -e native -f test_shift_predict
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
+extern unsigned int gears[6];
+extern volatile bool shiftLightOn;
+void setup();
+void loop();
+
+#define FRAME_US 10000              // M150 RPM frame period
+#define LEAD_MS 200                 // SHIFT_REACTION_MS
+
+/**
+ * @brief Shift point the firmware uses for a gear, gears[] has no entry for 6th so it shares 5th's
+ *
+ */
+static int shiftPoint(int gear)
+{
+  return gears[gear < 6 ? gear : 5];
+}
+
+static void sendGear(int gear)
+{
+  CAN_message_t msg;
+  msg.id = 0x64D;
+  msg.buf[6] = gear;
+  Can0.inject(msg);
+  loop();
+}
+
+static void sendRPM(int rpm)
+{
+  CAN_message_t msg;
+  msg.id = 0x640;
+  msg.buf[0] = rpm >> 8;
+  msg.buf[1] = rpm & 0xFF;
+  Can0.inject(msg);
+  loop();
+}
+
+/**
+ * @brief Settles the engine at rpm in gear, long enough for any earlier history to age out
+ *
+ */
+static void settle(int gear, int rpm)
+{
+  sendGear(gear);
+  for (int i = 0; i < 20; i++)
+  {
+    nativeAdvanceMicros(FRAME_US);
+    sendRPM(rpm);
+  }
+}
+
+/**
+ * @brief Ramps from rpm at slope RPM/s one frame at a time until the shift light comes on or end is reached
+ *
+ * @return int RPM of the frame the light came on at, -1 if it never did
+ */
+static int rampUntilLit(int rpm, int slope, int end)
+{
+  for (; rpm <= end; rpm += slope * (FRAME_US / 1000) / 1000)
+  {
+    nativeAdvanceMicros(FRAME_US);
+    sendRPM(rpm);
+    if (shiftLightOn)
+    {
+      return rpm;
+    }
+  }
+  return -1;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_ramp_fires_a_reaction_time_early_in_every_gear()
+{
+  const int slope = 4000; // RPM/s, lead at 200ms is 800 RPM
+  for (int gear = 1; gear <= 6; gear++)
+  {
+    int shift = shiftPoint(gear);
+    char msg[32];
+    snprintf(msg, sizeof(msg), "gear %d", gear);
+    settle(gear, shift - 3000);
+    TEST_ASSERT_FALSE_MESSAGE(shiftLightOn, msg);
+
+    int litAt = rampUntilLit(shift - 3000, slope, shift + 500);
+    int expected = shift - slope * LEAD_MS / 1000;
+    TEST_ASSERT_INT_WITHIN_MESSAGE(60, expected, litAt, msg); // within a frame's worth of RPM (40) plus rounding
+  }
+}
+
+void test_faster_ramp_fires_earlier()
+{
+  int shift = shiftPoint(3);
+  settle(3, shift - 4000);
+  int slowLit = rampUntilLit(shift - 4000, 2000, shift);
+  settle(3, shift - 4000);
+  int fastLit = rampUntilLit(shift - 4000, 6000, shift);
+
+  TEST_ASSERT_INT_WITHIN(60, shift - 400, slowLit);
+  TEST_ASSERT_INT_WITHIN(100, shift - 1200, fastLit);
+}
+
+void test_lead_is_capped()
+{
+  int shift = shiftPoint(4);
+  settle(4, shift - 5000);
+  int litAt = rampUntilLit(shift - 5000, 20000, shift); // 4000 RPM ahead uncapped
+  TEST_ASSERT_GREATER_OR_EQUAL(shift - 1500 - 200, litAt); // SHIFT_MAX_LEAD_RPM, plus one frame's step
+}
+
+void test_steady_or_falling_rpm_below_shift_never_fires()
+{
+  int shift = shiftPoint(2);
+  settle(2, shift - 50);
+  TEST_ASSERT_FALSE(shiftLightOn);
+
+  for (int rpm = shift - 50; rpm > shift - 2000; rpm -= 40)
+  {
+    nativeAdvanceMicros(FRAME_US);
+    sendRPM(rpm);
+    TEST_ASSERT_FALSE(shiftLightOn);
+  }
+}
+
+void test_at_the_shift_point_fires_without_a_history()
+{
+  int shift = shiftPoint(5);
+  sendGear(5); // gear change clears the history
+  nativeAdvanceMicros(FRAME_US);
+  sendRPM(shift);
+  TEST_ASSERT_TRUE(shiftLightOn);
+}
+
+void test_gap_in_rpm_frames_starts_the_history_over()
+{
+  int shift = shiftPoint(3);
+  settle(3, shift - 3500);
+  nativeAdvanceMicros(2000000); // 2s with no RPM, the stale samples would give a +1500 RPM/s slope
+  for (int i = 0; i < 6; i++)
+  {
+    sendRPM(shift - 300);
+    TEST_ASSERT_FALSE(shiftLightOn);
+    nativeAdvanceMicros(FRAME_US);
+  }
+}
+
+void test_long_gap_with_a_big_jump_doesnt_overflow()
+{
+  int shift = shiftPoint(1);
+  settle(1, 2000);
+  nativeAdvanceMicros(100000000); // 100s, (n*sumTR - sumT*sumR) * 1000000 would overflow int64 over this span
+  for (int i = 0; i < 6; i++)
+  {
+    sendRPM(shift - 1000);
+    TEST_ASSERT_FALSE(shiftLightOn);
+    nativeAdvanceMicros(FRAME_US);
+  }
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_ramp_fires_a_reaction_time_early_in_every_gear);
+  RUN_TEST(test_faster_ramp_fires_earlier);
+  RUN_TEST(test_lead_is_capped);
+  RUN_TEST(test_steady_or_falling_rpm_below_shift_never_fires);
+  RUN_TEST(test_at_the_shift_point_fires_without_a_history);
+  RUN_TEST(test_gap_in_rpm_frames_starts_the_history_over);
+  RUN_TEST(test_long_gap_with_a_big_jump_doesnt_overflow);
+  return UNITY_END();
+}
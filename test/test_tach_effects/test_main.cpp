@@ -0,0 +1,130 @@
+/**
+ * @file test_main.cpp
+ * @brief Tach LED blink and fade, stepped by ledAnimTimer, and what its interrupt leaves the interrupt mask at
+ *
+ * LED_W's analogWrite() level is read back through the shim: 0 is full brightness (the LED is lit while the pin
+ * is low), TACH_PWM_OFF holds it dark.
+ *
+ * pio test -e native -f test_tach_effects
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+extern FlexCAN_T4<CAN1, RX_SIZE_256, TX_SIZE_16> Can0;
+extern unsigned int gears[6];
+void setTachNightMode(bool night);
+void setup();
+void loop();
+
+#define LED_W_PIN 37                // LED_W
+#define PWM_OFF 256                 // TACH_PWM_OFF
+#define NIGHT_W_LEVEL (255 - 40)    // TACH_BRIGHTNESS_FULL - tachNightBrightness[TACH_W]
+#define BLINK_MS 80                 // TACH_OVERREV_BLINK_MS
+#define FADE_MS 300                 // TACH_FADE_MS
+#define FRAME_US 10000              // M150 RPM frame period, also LED_ANIM_TICK_MS
+
+static void sendGear(int gear)
+{
+  CAN_message_t msg;
+  msg.id = 0x64D;
+  msg.buf[6] = gear;
+  Can0.inject(msg);
+  loop();
+}
+
+static void sendRPM(int rpm)
+{
+  CAN_message_t msg;
+  msg.id = 0x640;
+  msg.buf[0] = rpm >> 8;
+  msg.buf[1] = rpm & 0xFF;
+  nativeAdvanceMicros(FRAME_US);
+  Can0.inject(msg);
+  loop();
+}
+
+/**
+ * @brief Holds RPM steady for ms milliseconds and counts how often LED_W's level changed
+ *
+ */
+static int holdRPM(int rpm, uint32_t ms)
+{
+  int changes = 0;
+  int last = nativePinOutput(LED_W_PIN);
+  for (uint32_t t = 0; t < ms; t += FRAME_US / 1000)
+  {
+    sendRPM(rpm);
+    int level = nativePinOutput(LED_W_PIN);
+    changes += level != last;
+    last = level;
+  }
+  return changes;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_over_rev_blinks_the_shift_light()
+{
+  sendGear(3);
+  holdRPM(gears[3] + 100, 200); // shift light on, steady
+  TEST_ASSERT_EQUAL(0, nativePinOutput(LED_W_PIN));
+
+  int changes = holdRPM(gears[3] + 400, 800); // past TACH_OVERREV_RPM
+  TEST_ASSERT_INT_WITHIN(1, 800 / BLINK_MS, changes);
+  TEST_ASSERT_TRUE(nativePinOutput(LED_W_PIN) == 0 || nativePinOutput(LED_W_PIN) == PWM_OFF); // on or off, no dimming
+}
+
+void test_back_under_the_over_rev_stops_the_blink()
+{
+  sendGear(3);
+  holdRPM(gears[3] + 400, 200);
+  holdRPM(gears[3] + 100, 20);
+  TEST_ASSERT_EQUAL(0, holdRPM(gears[3] + 100, 500));
+  TEST_ASSERT_EQUAL(0, nativePinOutput(LED_W_PIN)); // left lit, not stuck in the off half
+}
+
+void test_night_mode_fades_the_pwm_leds()
+{
+  sendGear(3);
+  holdRPM(gears[3] + 100, 100);
+  setTachNightMode(true);
+
+  int last = nativePinOutput(LED_W_PIN);
+  uint32_t reachedMs = 0;
+  for (uint32_t t = FRAME_US / 1000; t <= 2 * FADE_MS; t += FRAME_US / 1000)
+  {
+    sendRPM(gears[3] + 100);
+    int level = nativePinOutput(LED_W_PIN);
+    TEST_ASSERT_GREATER_OR_EQUAL(last, level); // only ever dims
+    if (level == NIGHT_W_LEVEL && reachedMs == 0)
+    {
+      reachedMs = t;
+    }
+    last = level;
+  }
+  TEST_ASSERT_EQUAL(NIGHT_W_LEVEL, last);
+  TEST_ASSERT_INT_WITHIN(3 * FRAME_US / 1000, FADE_MS, reachedMs);
+
+  setTachNightMode(false);
+  holdRPM(gears[3] + 100, 2 * FADE_MS);
+  TEST_ASSERT_EQUAL(0, nativePinOutput(LED_W_PIN));
+}
+
+void test_isrs_never_unmask_interrupts()
+{
+  TEST_ASSERT_EQUAL_UINT32(0, nativeISRUnmasks); // ledAnimTimer, the RPM mailbox and the FIFO all ran above
+}
+
+int main()
+{
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_over_rev_blinks_the_shift_light);
+  RUN_TEST(test_back_under_the_over_rev_stops_the_blink);
+  RUN_TEST(test_night_mode_fades_the_pwm_leds);
+  RUN_TEST(test_isrs_never_unmask_interrupts);
+  return UNITY_END();
+}
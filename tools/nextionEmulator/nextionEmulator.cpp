@@ -0,0 +1,509 @@
+/**
+ * @file nextionEmulator.cpp
+ * @brief Host-side Nextion LCD emulator, replays the byte stream the dashboard writes to Serial1 and reports
+ * link throughput, display-side load and per-component update latency
+ *
+ * Build and run on Linux (not part of the PlatformIO build):
+ *
+ *     g++ -std=c++17 -O2 -o nextionEmulator tools/nextionEmulator/nextionEmulator.cpp
+ *     ./nextionEmulator [options] capture.bin
+ *
+ * Input is either a raw Serial1 byte stream (everything is treated as written at t=0, which measures the
+ * saturated link), or a timestamped capture starting with NEXTION_CAPTURE_MAGIC followed by records of:
+ *
+ *     uint32_t micros     when the firmware handed the bytes to Serial1 (little endian)
+ *     uint16_t len        number of bytes (little endian)
+ *     uint8_t  data[len]
+ *
+ * Model, every number can be changed on the command line:
+ *  - bytes leave the UART back to back at baud / 10 bytes/s, never earlier than they were written
+ *  - the display buffers them in a serial input buffer of --buffer bytes, a byte arriving to a full buffer is
+ *    lost (the real display answers 0x24 and the command is garbled)
+ *  - commands are executed one at a time once their terminator has arrived, each costs --cmd-us, and a
+ *    component update costs another --repaint-us unless it's between ref_stop and ref_star, where all
+ *    updated components repaint once at ref_star
+ *  - a component's update latency runs from the write of the command's first byte to the end of its repaint
+ *
+ * baud= in the stream switches the emulated link rate, like the real display.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#define NEXTION_CAPTURE_MAGIC "NXCAP1\n"
+#define NEXTION_TERMINATOR 0xFF
+
+/**
+ * @brief Emulated display timing, defaults are rough figures for a basic-series display
+ *
+ */
+struct EmulatorConfig
+{
+  uint32_t baud = 9600;
+  uint32_t bufferSize = 1024;      // serial input buffer of the display
+  uint32_t cmdUs = 100;            // parse + execute of one instruction
+  uint32_t repaintUs = 1500;       // redraw of one component
+  bool dump = false;               // print every component's final state
+};
+
+/**
+ * @brief One byte on its way to the display
+ *
+ */
+struct StreamByte
+{
+  uint8_t value;
+  uint64_t writeUs;                // when the firmware wrote it
+};
+
+/**
+ * @brief What the emulator knows about a component on the current page
+ *
+ */
+struct ComponentState
+{
+  std::string value;               // last value assigned, as sent
+  uint32_t updates = 0;
+  uint64_t latencySumUs = 0;
+  uint64_t latencyMaxUs = 0;
+};
+
+struct EmulatorStats
+{
+  uint64_t bytes = 0;
+  uint64_t bytesLost = 0;          // arrived to a full input buffer
+  uint64_t overflows = 0;          // times the buffer overran (0x24 on the real display)
+  uint64_t commands = 0;
+  uint64_t invalid = 0;            // commands the display would reject
+  uint64_t pageChanges = 0;
+  uint64_t repaints = 0;
+  uint64_t batches = 0;            // ref_stop/ref_star pairs
+  uint64_t addtPoints = 0;
+  uint64_t firstUs = 0;
+  uint64_t lastUs = 0;             // time the last command finished
+};
+
+/**
+ * @brief Pending update inside a ref_stop/ref_star batch, latency is only known once it's painted
+ *
+ */
+struct DeferredUpdate
+{
+  std::string component;
+  uint64_t writeUs;
+};
+
+class NextionEmulator
+{
+public:
+  explicit NextionEmulator(const EmulatorConfig &config) : cfg(config), baud(config.baud) {}
+
+  /**
+   * @brief Runs the whole stream through the link and display model
+   *
+   */
+  void run(const std::vector<StreamByte> &stream)
+  {
+    uint64_t uartFreeUs = 0;
+    std::string cmd;
+    uint64_t cmdWriteUs = 0;
+    uint8_t terminators = 0;
+    uint32_t addtRemaining = 0;
+
+    for (const StreamByte &b : stream)
+    {
+      uint64_t byteUs = 10000000ULL / baud;
+      uint64_t arrivalUs = std::max(b.writeUs, uartFreeUs) + byteUs;
+      uartFreeUs = arrivalUs;
+      if (stats.bytes++ == 0)
+      {
+        stats.firstUs = b.writeUs;
+      }
+
+      // free the buffer space of every command the display has finished by now
+      while (!consumed.empty() && consumed.front().first <= arrivalUs)
+      {
+        buffered -= consumed.front().second;
+        consumed.pop_front();
+      }
+      if (buffered + cmd.size() >= cfg.bufferSize)
+      {
+        stats.bytesLost++;
+        if (!overflowing)
+        {
+          stats.overflows++;
+          overflowing = true;
+        }
+        continue;
+      }
+      overflowing = false;
+
+      if (addtRemaining > 0) // transparent data after an addt
+      {
+        cmd.push_back((char)b.value);
+        if (--addtRemaining == 0)
+        {
+          stats.addtPoints += cmd.size();
+          finishCommand(cmd.size(), arrivalUs, 0);
+          cmd.clear();
+        }
+        continue;
+      }
+
+      if (cmd.empty() && terminators == 0)
+      {
+        cmdWriteUs = b.writeUs;
+      }
+      if (b.value == NEXTION_TERMINATOR)
+      {
+        if (++terminators < 3)
+        {
+          continue;
+        }
+        uint32_t len = cmd.size() + 3;
+        addtRemaining = execute(cmd, arrivalUs, cmdWriteUs, len);
+        cmd.clear();
+        terminators = 0;
+        if (addtRemaining > 0)
+        {
+          cmdWriteUs = b.writeUs;
+        }
+        continue;
+      }
+      for (; terminators > 0; terminators--) // a lone 0xFF is part of the command
+      {
+        cmd.push_back((char)NEXTION_TERMINATOR);
+      }
+      cmd.push_back((char)b.value);
+    }
+  }
+
+  /**
+   * @brief Prints the benchmark report
+   *
+   */
+  void report() const
+  {
+    double seconds = (stats.lastUs > stats.firstUs) ? (stats.lastUs - stats.firstUs) / 1e6 : 0.0;
+    printf("link                %u baud (%u bytes/s)\n", baud, baud / 10);
+    printf("duration            %.3f s\n", seconds);
+    printf("bytes               %llu (%.1f/s)\n", (unsigned long long)stats.bytes, seconds > 0 ? stats.bytes / seconds : 0.0);
+    printf("commands            %llu (%.1f/s)\n", (unsigned long long)stats.commands, seconds > 0 ? stats.commands / seconds : 0.0);
+    printf("invalid commands    %llu\n", (unsigned long long)stats.invalid);
+    printf("buffer overflows    %llu (%llu bytes lost)\n", (unsigned long long)stats.overflows, (unsigned long long)stats.bytesLost);
+    printf("page changes        %llu\n", (unsigned long long)stats.pageChanges);
+    printf("repaints            %llu (%.1f/s)\n", (unsigned long long)stats.repaints, seconds > 0 ? stats.repaints / seconds : 0.0);
+    printf("ref batches         %llu\n", (unsigned long long)stats.batches);
+    printf("waveform points     %llu\n", (unsigned long long)stats.addtPoints);
+    printf("display busy        %.1f %%\n", seconds > 0 ? busyUs / 1e4 / seconds : 0.0);
+
+    printf("\n%-20s %8s %10s %12s %12s\n", "component", "updates", "updates/s", "avg lat ms", "max lat ms");
+    for (const auto &entry : totals)
+    {
+      const ComponentState &c = entry.second;
+      printf("%-20s %8u %10.1f %12.2f %12.2f\n", entry.first.c_str(), c.updates, seconds > 0 ? c.updates / seconds : 0.0,
+             c.updates ? c.latencySumUs / 1e3 / c.updates : 0.0, c.latencyMaxUs / 1e3);
+    }
+
+    if (cfg.dump)
+    {
+      printf("\npage %s\n", page.c_str());
+      for (const auto &entry : components)
+      {
+        printf("  %s = %s\n", entry.first.c_str(), entry.second.value.c_str());
+      }
+    }
+  }
+
+private:
+  /**
+   * @brief Marks a command's bytes as held in the input buffer until the display is done with it
+   *
+   * @return uint64_t when the display finishes it
+   */
+  uint64_t finishCommand(uint32_t len, uint64_t completeUs, uint32_t extraUs)
+  {
+    uint64_t startUs = std::max(completeUs, displayFreeUs);
+    displayFreeUs = startUs + cfg.cmdUs + extraUs;
+    busyUs += cfg.cmdUs + extraUs;
+    buffered += len;
+    consumed.push_back({displayFreeUs, len});
+    stats.lastUs = std::max(stats.lastUs, displayFreeUs);
+    return displayFreeUs;
+  }
+
+  /**
+   * @brief Records a painted component update
+   *
+   */
+  void painted(const std::string &component, uint64_t writeUs, uint64_t doneUs)
+  {
+    uint64_t latency = doneUs - writeUs;
+    for (ComponentState *c : {&components[component], &totals[component]})
+    {
+      c->updates++;
+      c->latencySumUs += latency;
+      c->latencyMaxUs = std::max(c->latencyMaxUs, latency);
+    }
+  }
+
+  /**
+   * @brief Executes one complete instruction against the component model
+   *
+   * @return uint32_t number of transparent data bytes that follow (addt), 0 otherwise
+   */
+  uint32_t execute(const std::string &cmd, uint64_t completeUs, uint64_t writeUs, uint32_t len)
+  {
+    stats.commands++;
+
+    if (cmd.rfind("page ", 0) == 0)
+    {
+      stats.pageChanges++;
+      page = cmd.substr(5);
+      components.clear(); // components go back to their HMI defaults
+      deferred.clear();
+      refStopped = false;
+      finishCommand(len, completeUs, cfg.repaintUs * 4); // full screen redraw
+      return 0;
+    }
+    if (cmd == "ref_stop")
+    {
+      refStopped = true;
+      finishCommand(len, completeUs, 0);
+      return 0;
+    }
+    if (cmd == "ref_star")
+    {
+      std::set<std::string> dirty;
+      for (const DeferredUpdate &u : deferred)
+      {
+        dirty.insert(u.component);
+      }
+      uint64_t doneUs = finishCommand(len, completeUs, cfg.repaintUs * dirty.size());
+      for (const DeferredUpdate &u : deferred)
+      {
+        painted(u.component, u.writeUs, doneUs);
+      }
+      stats.repaints += dirty.size();
+      stats.batches += refStopped ? 1 : 0;
+      deferred.clear();
+      refStopped = false;
+      return 0;
+    }
+    if (cmd.rfind("addt ", 0) == 0)
+    {
+      unsigned objId, channel, qty;
+      if (sscanf(cmd.c_str() + 5, "%u,%u,%u", &objId, &channel, &qty) != 3 || qty == 0)
+      {
+        stats.invalid++;
+        finishCommand(len, completeUs, 0);
+        return 0;
+      }
+      finishCommand(len, completeUs, 0);
+      return qty;
+    }
+    if (cmd.rfind("baud=", 0) == 0)
+    {
+      finishCommand(len, completeUs, 0);
+      baud = strtoul(cmd.c_str() + 5, NULL, 10);
+      return 0;
+    }
+    if (cmd.rfind("get ", 0) == 0 || cmd.rfind("bkcmd=", 0) == 0)
+    {
+      finishCommand(len, completeUs, 0);
+      return 0;
+    }
+
+    size_t eq = cmd.find('=');
+    size_t dot = cmd.find('.');
+    if (eq == std::string::npos || eq == 0)
+    {
+      stats.invalid++;
+      finishCommand(len, completeUs, 0);
+      return 0;
+    }
+
+    std::string target = cmd.substr(0, eq);
+    std::string value = cmd.substr(eq + 1);
+    std::string attr = (dot != std::string::npos && dot < eq) ? cmd.substr(dot + 1, eq - dot - 1) : "";
+    bool valid = !value.empty();
+    if (attr == "txt")
+    {
+      valid = value.size() >= 2 && value.front() == '"' && value.back() == '"';
+    }
+    else if (attr == "val" || attr == "pic" || attr.empty()) // attr.empty(): a global variable, e.g. dashFlags=
+    {
+      char *end;
+      strtol(value.c_str(), &end, 10);
+      valid = *end == '\0';
+    }
+    if (!valid)
+    {
+      stats.invalid++;
+      finishCommand(len, completeUs, 0);
+      return 0;
+    }
+
+    components[target].value = value;
+    if (attr.empty())
+    {
+      finishCommand(len, completeUs, 0); // variables don't draw anything
+    }
+    else if (refStopped)
+    {
+      finishCommand(len, completeUs, 0);
+      deferred.push_back({target, writeUs});
+    }
+    else
+    {
+      uint64_t doneUs = finishCommand(len, completeUs, cfg.repaintUs);
+      painted(target, writeUs, doneUs);
+      stats.repaints++;
+    }
+    return 0;
+  }
+
+  EmulatorConfig cfg;
+  uint32_t baud;
+
+  std::string page;
+  std::map<std::string, ComponentState> components; // current page
+  std::map<std::string, ComponentState> totals;     // every page, for the report
+  bool refStopped = false;
+  std::vector<DeferredUpdate> deferred;
+
+  uint64_t displayFreeUs = 0;
+  uint64_t busyUs = 0;
+  uint32_t buffered = 0;                          // bytes of parsed commands the display hasn't finished
+  std::deque<std::pair<uint64_t, uint32_t>> consumed; // (finish time, bytes) of those commands
+  bool overflowing = false;
+
+  EmulatorStats stats;
+};
+
+/**
+ * @brief Reads a capture file, or a raw byte stream written all at once
+ *
+ */
+static bool loadStream(const char *path, std::vector<StreamByte> &stream)
+{
+  FILE *f = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+  if (f == NULL)
+  {
+    perror(path);
+    return false;
+  }
+
+  std::vector<uint8_t> raw;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+  {
+    raw.insert(raw.end(), chunk, chunk + n);
+  }
+  if (f != stdin)
+  {
+    fclose(f);
+  }
+
+  size_t magicLen = strlen(NEXTION_CAPTURE_MAGIC);
+  if (raw.size() < magicLen || memcmp(raw.data(), NEXTION_CAPTURE_MAGIC, magicLen) != 0)
+  {
+    for (uint8_t c : raw)
+    {
+      stream.push_back({c, 0});
+    }
+    return true;
+  }
+
+  size_t pos = magicLen;
+  while (pos + 6 <= raw.size())
+  {
+    uint32_t us = raw[pos] | (raw[pos + 1] << 8) | (raw[pos + 2] << 16) | ((uint32_t)raw[pos + 3] << 24);
+    uint16_t len = raw[pos + 4] | (raw[pos + 5] << 8);
+    pos += 6;
+    if (pos + len > raw.size())
+    {
+      fprintf(stderr, "%s: truncated record\n", path);
+      break;
+    }
+    for (uint16_t i = 0; i < len; i++)
+    {
+      stream.push_back({raw[pos + i], us});
+    }
+    pos += len;
+  }
+  return true;
+}
+
+static void usage(const char *argv0)
+{
+  fprintf(stderr,
+          "usage: %s [--baud N] [--buffer BYTES] [--cmd-us US] [--repaint-us US] [--dump] capture|-\n",
+          argv0);
+}
+
+int main(int argc, char **argv)
+{
+  EmulatorConfig cfg;
+  const char *path = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--baud" && hasValue)
+    {
+      cfg.baud = strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--buffer" && hasValue)
+    {
+      cfg.bufferSize = strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--cmd-us" && hasValue)
+    {
+      cfg.cmdUs = strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--repaint-us" && hasValue)
+    {
+      cfg.repaintUs = strtoul(argv[++i], NULL, 10);
+    }
+    else if (arg == "--dump")
+    {
+      cfg.dump = true;
+    }
+    else if (path == NULL && (arg == "-" || arg[0] != '-'))
+    {
+      path = argv[i];
+    }
+    else
+    {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (path == NULL || cfg.baud == 0)
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<StreamByte> stream;
+  if (!loadStream(path, stream))
+  {
+    return 1;
+  }
+
+  NextionEmulator emulator(cfg);
+  emulator.run(stream);
+  emulator.report();
+  return 0;
+}